@@ -0,0 +1,72 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+//! Cache key of direction, global channel, and query name
+typedef std::tuple<int, size_t, std::string> SoapyMultiCacheKey;
+
+/*!
+ * A thread-safe cache of query results which is filled lazily.
+ * The query is performed without holding the lock, and a result
+ * is only stored when the cache was not cleared in the meantime.
+ */
+template <typename Type>
+class SoapyMultiCache
+{
+public:
+    SoapyMultiCache(void):
+        _generation(0)
+    {
+        return;
+    }
+
+    //! Get the cached value or fill it with the result of query()
+    template <typename QueryFcn>
+    Type get(const SoapyMultiCacheKey &key, const QueryFcn &query)
+    {
+        size_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _values.find(key);
+            if (it != _values.end()) return it->second;
+            generation = _generation;
+        }
+
+        const Type value = query();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (generation == _generation) _values[key] = value;
+        return value;
+    }
+
+    //! Forget all cached values
+    void clear(void)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _values.clear();
+        _generation++;
+    }
+
+    //! Forget the cached values for which predicate(key) is true
+    template <typename Predicate>
+    void erase(const Predicate &predicate)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = _values.begin(); it != _values.end();)
+        {
+            if (predicate(it->first)) it = _values.erase(it);
+            else ++it;
+        }
+        _generation++;
+    }
+
+private:
+    std::mutex _mutex;
+    std::map<SoapyMultiCacheKey, Type> _values;
+    size_t _generation;
+};
@@ -0,0 +1,110 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+//! A global channel as the index of its device and the channel on that device
+struct SoapyMultiChannel
+{
+    size_t deviceIndex;
+    size_t localChannel;
+};
+
+//! The channels of a stream which belong to one device
+struct SoapyMultiChannelGroup
+{
+    size_t deviceIndex;
+    std::vector<size_t> localChannels; //in stream order
+    std::vector<size_t> buffIndexes; //position of each channel in the stream channel list
+    bool contiguous; //the positions are consecutive, so the stream buffers can be used in place
+};
+
+/*!
+ * The channels of one direction across all devices.
+ * The global channels of each device form a contiguous range in device order,
+ * so both directions of the lookup are constant time.
+ */
+class SoapyMultiChannelMap
+{
+public:
+    //! Rebuild the map given the number of channels of each device
+    void reload(const std::vector<size_t> &numChannels)
+    {
+        _channels.clear();
+        _firstChannels.clear();
+        _numChannels = numChannels;
+        for (size_t i = 0; i < numChannels.size(); i++)
+        {
+            _firstChannels.push_back(_channels.size());
+            for (size_t ch = 0; ch < numChannels[i]; ch++)
+            {
+                _channels.push_back(SoapyMultiChannel{i, ch});
+            }
+        }
+    }
+
+    //! The number of global channels
+    size_t size(void) const
+    {
+        return _channels.size();
+    }
+
+    //! The device and local channel of the global channel, throws std::out_of_range
+    const SoapyMultiChannel &at(const size_t channel) const
+    {
+        return _channels.at(channel);
+    }
+
+    //! The global channel of the local channel on the device
+    size_t toGlobal(const size_t deviceIndex, const size_t localChannel) const
+    {
+        return _firstChannels.at(deviceIndex) + localChannel;
+    }
+
+    //! The first global channel of the device
+    size_t firstChannel(const size_t deviceIndex) const
+    {
+        return _firstChannels.at(deviceIndex);
+    }
+
+    //! The number of channels of the device
+    size_t numChannels(const size_t deviceIndex) const
+    {
+        return _numChannels.at(deviceIndex);
+    }
+
+    /*!
+     * Group the channels of a stream by device, one group per device
+     * in the order of the first channel of each device in the list.
+     * Channels of a device which are not adjacent in the list, such as {3, 0, 2},
+     * still share the group and are found through the buffer positions.
+     */
+    std::vector<SoapyMultiChannelGroup> group(const std::vector<size_t> &channels) const
+    {
+        static const size_t noGroup = ~size_t(0);
+        std::vector<SoapyMultiChannelGroup> groups;
+        std::vector<size_t> groupIndexes(_numChannels.size(), noGroup);
+        for (size_t i = 0; i < channels.size(); i++)
+        {
+            const auto &channel = this->at(channels[i]);
+            auto &groupIndex = groupIndexes[channel.deviceIndex];
+            if (groupIndex == noGroup)
+            {
+                groupIndex = groups.size();
+                groups.push_back(SoapyMultiChannelGroup{channel.deviceIndex, {}, {}, true});
+            }
+            auto &group = groups[groupIndex];
+            if (not group.buffIndexes.empty() and group.buffIndexes.back()+1 != i) group.contiguous = false;
+            group.localChannels.push_back(channel.localChannel);
+            group.buffIndexes.push_back(i);
+        }
+        return groups;
+    }
+
+private:
+    std::vector<SoapyMultiChannel> _channels;
+    std::vector<size_t> _firstChannels;
+    std::vector<size_t> _numChannels;
+};
@@ -0,0 +1,390 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <SoapySDR/Formats.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+//! Elements per chunk when a conversion passes through CF32
+static const size_t SOAPY_MULTI_CONVERT_CHUNK = 512;
+
+/*******************************************************************
+ * Conversion kernels to and from complex float
+ * The kernels use the widest vector instructions enabled for the build,
+ * the scalar loops handle the tail and the other architectures.
+ ******************************************************************/
+
+//! Convert numElems complex elements to CF32 and multiply by scale
+typedef void (*SoapyMultiToCF32)(const void *in, float *out, const size_t numElems, const float scale);
+
+//! Multiply numElems CF32 elements by scale and convert them, integers saturate
+typedef void (*SoapyMultiFromCF32)(const float *in, void *out, const size_t numElems, const float scale);
+
+static inline int32_t saturateCF32(const float x, const int32_t limit)
+{
+    const auto y = std::lrint(x);
+    return int32_t(std::max<long>(-limit, std::min<long>(limit-1, y)));
+}
+
+static inline void convertCS16ToCF32(const void *in_, float *out, const size_t numElems, const float scale)
+{
+    auto in = static_cast<const int16_t *>(in_);
+    const size_t n = numElems*2;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 s = _mm256_set1_ps(scale);
+    for (; i+8 <= n; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in+i));
+        _mm256_storeu_ps(out+i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x)), s));
+    }
+#elif defined(__SSE2__)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i+8 <= n; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in+i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out+i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i+8 <= n; i += 8)
+    {
+        const int16x8_t x = vld1q_s16(in+i);
+        vst1q_f32(out+i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(out+i+4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+#endif
+    for (; i < n; i++) out[i] = float(in[i])*scale;
+}
+
+static inline void convertCF32ToCS16(const float *in, void *out_, const size_t numElems, const float scale)
+{
+    auto out = static_cast<int16_t *>(out_);
+    const size_t n = numElems*2;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 s = _mm256_set1_ps(scale);
+    for (; i+16 <= n; i += 16)
+    {
+        const __m256i lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in+i), s));
+        const __m256i hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in+i+8), s));
+        //the pack works within 128 bit lanes, restore the element order
+        const __m256i y = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out+i), y);
+    }
+#elif defined(__SSE2__)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i+8 <= n; i += 8)
+    {
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+i), s));
+        const __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+i+4), s));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out+i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i+8 <= n; i += 8)
+    {
+        const int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in+i), scale));
+        const int32x4_t hi = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in+i+4), scale));
+        vst1q_s16(out+i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+    for (; i < n; i++) out[i] = int16_t(saturateCF32(in[i]*scale, 1 << 15));
+}
+
+static inline void convertCS8ToCF32(const void *in_, float *out, const size_t numElems, const float scale)
+{
+    auto in = static_cast<const int8_t *>(in_);
+    for (size_t i = 0; i < numElems*2; i++) out[i] = float(in[i])*scale;
+}
+
+static inline void convertCF32ToCS8(const float *in, void *out_, const size_t numElems, const float scale)
+{
+    auto out = static_cast<int8_t *>(out_);
+    for (size_t i = 0; i < numElems*2; i++) out[i] = int8_t(saturateCF32(in[i]*scale, 1 << 7));
+}
+
+//! CS12 packs each element into 3 bytes, the values are in the upper 12 bits of an int16
+static inline void convertCS12ToCF32(const void *in_, float *out, const size_t numElems, const float scale)
+{
+    auto in = static_cast<const uint8_t *>(in_);
+    const float scale12 = scale/16;
+    for (size_t i = 0; i < numElems; i++)
+    {
+        const uint16_t part0 = in[i*3+0];
+        const uint16_t part1 = in[i*3+1];
+        const uint16_t part2 = in[i*3+2];
+        out[i*2+0] = float(int16_t(uint16_t((part1 << 12) | (part0 << 4))))*scale12;
+        out[i*2+1] = float(int16_t(uint16_t((part2 << 8) | (part1 & 0xf0))))*scale12;
+    }
+}
+
+static inline void convertCF32ToCS12(const float *in, void *out_, const size_t numElems, const float scale)
+{
+    auto out = static_cast<uint8_t *>(out_);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        const uint16_t re = uint16_t(unsigned(saturateCF32(in[i*2+0]*scale, 1 << 11)) << 4);
+        const uint16_t im = uint16_t(unsigned(saturateCF32(in[i*2+1]*scale, 1 << 11)) << 4);
+        out[i*3+0] = uint8_t(re >> 4);
+        out[i*3+1] = uint8_t((im & 0xf0) | (re >> 12));
+        out[i*3+2] = uint8_t(im >> 8);
+    }
+}
+
+static inline void convertCF32ToCF32(const void *in_, float *out, const size_t numElems, const float scale)
+{
+    auto in = static_cast<const float *>(in_);
+    for (size_t i = 0; i < numElems*2; i++) out[i] = in[i]*scale;
+}
+
+static inline void convertCF32ToCF32Out(const float *in, void *out, const size_t numElems, const float scale)
+{
+    convertCF32ToCF32(in, static_cast<float *>(out), numElems, scale);
+}
+
+static inline void convertCF64ToCF32(const void *in_, float *out, const size_t numElems, const float scale)
+{
+    auto in = static_cast<const double *>(in_);
+    for (size_t i = 0; i < numElems*2; i++) out[i] = float(in[i]*scale);
+}
+
+static inline void convertCF32ToCF64(const float *in, void *out_, const size_t numElems, const float scale)
+{
+    auto out = static_cast<double *>(out_);
+    for (size_t i = 0; i < numElems*2; i++) out[i] = double(in[i])*scale;
+}
+
+/*******************************************************************
+ * Channel interleaving
+ * Each output frame holds one element of every channel in order.
+ * Frames of 2 channels of 4 or 8 byte elements (CS16, CF32) and
+ * frames of 4 channels of 4 byte elements use vector shuffles.
+ ******************************************************************/
+
+template <typename Type>
+static inline void interleaveScalar(const void * const *in, const size_t numChans, void *out_, const size_t begin, const size_t numElems)
+{
+    auto out = static_cast<Type *>(out_);
+    for (size_t ch = 0; ch < numChans; ch++)
+    {
+        auto inCh = static_cast<const Type *>(in[ch]);
+        for (size_t i = begin; i < numElems; i++) out[i*numChans+ch] = inCh[i];
+    }
+}
+
+//! \return the number of elements which were interleaved, the rest is left for the scalar loop
+static inline size_t interleaveVector(const void * const *in, const size_t numChans, void *out, const size_t numElems, const size_t elemSize)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (numChans == 2 and elemSize == 4)
+    {
+        auto in0 = static_cast<const float *>(in[0]), in1 = static_cast<const float *>(in[1]);
+        auto outF = static_cast<float *>(out);
+        for (; i+4 <= numElems; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps(in0+i), b = _mm_loadu_ps(in1+i);
+            _mm_storeu_ps(outF+i*2, _mm_unpacklo_ps(a, b));
+            _mm_storeu_ps(outF+i*2+4, _mm_unpackhi_ps(a, b));
+        }
+    }
+    if (numChans == 2 and elemSize == 8)
+    {
+        auto in0 = static_cast<const double *>(in[0]), in1 = static_cast<const double *>(in[1]);
+        auto outD = static_cast<double *>(out);
+        for (; i+2 <= numElems; i += 2)
+        {
+            const __m128d a = _mm_loadu_pd(in0+i), b = _mm_loadu_pd(in1+i);
+            _mm_storeu_pd(outD+i*2, _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(outD+i*2+2, _mm_unpackhi_pd(a, b));
+        }
+    }
+    if (numChans == 4 and elemSize == 4)
+    {
+        auto outF = static_cast<float *>(out);
+        for (; i+4 <= numElems; i += 4)
+        {
+            __m128 r0 = _mm_loadu_ps(static_cast<const float *>(in[0])+i);
+            __m128 r1 = _mm_loadu_ps(static_cast<const float *>(in[1])+i);
+            __m128 r2 = _mm_loadu_ps(static_cast<const float *>(in[2])+i);
+            __m128 r3 = _mm_loadu_ps(static_cast<const float *>(in[3])+i);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(outF+i*4, r0);
+            _mm_storeu_ps(outF+i*4+4, r1);
+            _mm_storeu_ps(outF+i*4+8, r2);
+            _mm_storeu_ps(outF+i*4+12, r3);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (numChans == 2 and elemSize == 4)
+    {
+        auto in0 = static_cast<const float *>(in[0]), in1 = static_cast<const float *>(in[1]);
+        for (; i+4 <= numElems; i += 4)
+        {
+            const float32x4x2_t x = {{vld1q_f32(in0+i), vld1q_f32(in1+i)}};
+            vst2q_f32(static_cast<float *>(out)+i*2, x);
+        }
+    }
+    if (numChans == 2 and elemSize == 8)
+    {
+        auto in0 = static_cast<const float *>(in[0]), in1 = static_cast<const float *>(in[1]);
+        for (; i+2 <= numElems; i += 2)
+        {
+            const float64x2x2_t x = {{vreinterpretq_f64_f32(vld1q_f32(in0+i*2)), vreinterpretq_f64_f32(vld1q_f32(in1+i*2))}};
+            vst2q_f64(static_cast<double *>(out)+i*2, x);
+        }
+    }
+    if (numChans == 4 and elemSize == 4)
+    {
+        for (; i+4 <= numElems; i += 4)
+        {
+            const float32x4x4_t x = {{
+                vld1q_f32(static_cast<const float *>(in[0])+i), vld1q_f32(static_cast<const float *>(in[1])+i),
+                vld1q_f32(static_cast<const float *>(in[2])+i), vld1q_f32(static_cast<const float *>(in[3])+i)}};
+            vst4q_f32(static_cast<float *>(out)+i*4, x);
+        }
+    }
+#else
+    (void)in; (void)numChans; (void)out; (void)numElems; (void)elemSize;
+#endif
+    return i;
+}
+
+//! Interleave numElems elements of numChans channel buffers into out
+static inline void interleaveChannels(const void * const *in, const size_t numChans, void *out, const size_t numElems, const size_t elemSize)
+{
+    const size_t begin = interleaveVector(in, numChans, out, numElems, elemSize);
+    if (elemSize == 4) return interleaveScalar<uint32_t>(in, numChans, out, begin, numElems);
+    if (elemSize == 8) return interleaveScalar<uint64_t>(in, numChans, out, begin, numElems);
+
+    auto outB = static_cast<char *>(out);
+    for (size_t ch = 0; ch < numChans; ch++)
+    {
+        auto inCh = static_cast<const char *>(in[ch]);
+        for (size_t i = begin; i < numElems; i++)
+        {
+            std::memcpy(outB + (i*numChans+ch)*elemSize, inCh + i*elemSize, elemSize);
+        }
+    }
+}
+
+/*******************************************************************
+ * Format helpers
+ ******************************************************************/
+
+//! True when the wrapper can convert to and from the format
+static inline bool isConvertibleFormat(const std::string &format)
+{
+    return format == SOAPY_SDR_CS8 or format == SOAPY_SDR_CS12 or format == SOAPY_SDR_CS16 or
+        format == SOAPY_SDR_CF32 or format == SOAPY_SDR_CF64;
+}
+
+//! The full-scale value which the format uses when no device reports one
+static inline double nominalFullScale(const std::string &format)
+{
+    if (format == SOAPY_SDR_CS8) return 1 << 7;
+    if (format == SOAPY_SDR_CS12) return 1 << 11;
+    if (format == SOAPY_SDR_CS16) return 1 << 15;
+    return 1.0;
+}
+
+/*!
+ * Converts elements between two of the convertible formats.
+ * The values are scaled so that the full-scale of the input
+ * becomes the full-scale of the output. Formats other than CF32
+ * pass through CF32 in chunks of a small buffer on the stack.
+ * The convert() call does not modify the converter, so
+ * several threads may convert with the same converter.
+ */
+class SoapyMultiConverter
+{
+public:
+    //! An empty converter, the formats are the same
+    SoapyMultiConverter(void):
+        _inSize(0),
+        _outSize(0),
+        _toCF32(nullptr),
+        _fromCF32(nullptr),
+        _scale(1.0f)
+    {
+        return;
+    }
+
+    SoapyMultiConverter(const std::string &inFormat, const double inFullScale, const std::string &outFormat, const double outFullScale):
+        _inSize(SoapySDR::formatToSize(inFormat)),
+        _outSize(SoapySDR::formatToSize(outFormat)),
+        _toCF32(toCF32(inFormat)),
+        _fromCF32(fromCF32(outFormat)),
+        _scale(float(outFullScale/inFullScale))
+    {
+        return;
+    }
+
+    bool empty(void) const
+    {
+        return _toCF32 == nullptr;
+    }
+
+    //! The size in bytes of one input element
+    size_t inSize(void) const
+    {
+        return _inSize;
+    }
+
+    void convert(const void *in, void *out, const size_t numElems) const
+    {
+        //one kernel is enough when either side is CF32
+        if (_fromCF32 == &convertCF32ToCF32Out) return _toCF32(in, static_cast<float *>(out), numElems, _scale);
+        if (_toCF32 == &convertCF32ToCF32) return _fromCF32(static_cast<const float *>(in), out, numElems, _scale);
+
+        float chunk[2*SOAPY_MULTI_CONVERT_CHUNK];
+        for (size_t i = 0; i < numElems; i += SOAPY_MULTI_CONVERT_CHUNK)
+        {
+            const size_t n = std::min<size_t>(SOAPY_MULTI_CONVERT_CHUNK, numElems-i);
+            _toCF32(static_cast<const char *>(in) + i*_inSize, chunk, n, _scale);
+            _fromCF32(chunk, static_cast<char *>(out) + i*_outSize, n, 1.0f);
+        }
+    }
+
+private:
+    static SoapyMultiToCF32 toCF32(const std::string &format)
+    {
+        if (format == SOAPY_SDR_CS8) return &convertCS8ToCF32;
+        if (format == SOAPY_SDR_CS12) return &convertCS12ToCF32;
+        if (format == SOAPY_SDR_CS16) return &convertCS16ToCF32;
+        if (format == SOAPY_SDR_CF32) return &convertCF32ToCF32;
+        if (format == SOAPY_SDR_CF64) return &convertCF64ToCF32;
+        return nullptr;
+    }
+
+    static SoapyMultiFromCF32 fromCF32(const std::string &format)
+    {
+        if (format == SOAPY_SDR_CS8) return &convertCF32ToCS8;
+        if (format == SOAPY_SDR_CS12) return &convertCF32ToCS12;
+        if (format == SOAPY_SDR_CS16) return &convertCF32ToCS16;
+        if (format == SOAPY_SDR_CF32) return &convertCF32ToCF32Out;
+        if (format == SOAPY_SDR_CF64) return &convertCF32ToCF64;
+        return nullptr;
+    }
+
+    size_t _inSize;
+    size_t _outSize;
+    SoapyMultiToCF32 _toCF32;
+    SoapyMultiFromCF32 _fromCF32;
+    float _scale;
+};
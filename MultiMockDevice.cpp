@@ -0,0 +1,847 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * An in-memory mock device for testing and benchmarking the wrapper.
+ * Receive streams generate a ramp: the real part of each element is
+ * the sample count (modulo 2^15) and the imaginary part is the channel.
+ * Transmit streams count the elements and discard them,
+ * a write with SOAPY_SDR_END_BURST queues a burst ack for readStreamStatus.
+ * The written elements of the first channel are checked against the same ramp
+ * from zero, so a test can tell when elements were sent twice or skipped.
+ * An activation with SOAPY_SDR_HAS_TIME starts the stream at that hardware time,
+ * and the sample count restarts from the start time.
+ * A call which would take longer than its timeout waits out the timeout
+ * and returns SOAPY_SDR_TIMEOUT, as does acquiring a direct access buffer
+ * while every buffer of the stream is acquired.
+ *
+ * Device args:
+ *  - channels: number of channels per direction (default 1)
+ *  - rate: initial sample rate in Sps (default 1e6)
+ *  - mtu: maximum elements per stream call (default 1024)
+ *  - latency_us: delay added to every stream call (default 0)
+ *  - jitter_us: random extra delay of up to this amount (default 0)
+ *  - short_reads: probability that a call moves fewer elements (default 0)
+ *  - num_buffs: number of direct access buffers (default 8)
+ *  - ticks: initial sample count of receive streams (default 0)
+ *  - activate_ret: result of activateStream, the stream stays inactive when non-zero (default 0)
+ *  - timed_stop: when false a deactivateStream with a time is not supported (default true)
+ *  - sensor_us: delay added to every sensor read (default 0)
+ *  - register_us: delay added to every register call (default 0)
+ *  - make_error: when true, making the device throws (default false)
+ *  - read_error: when non-zero, every readStream of an active stream fails with this error (default 0)
+ *  - status_error: when non-zero, every readStreamStatus of a transmit stream fails with this error (default 0)
+ *  - timed_tune: when true, a setFrequency at a command time takes effect
+ *    once the hardware time reaches the command time (default false)
+ *
+ * Sensors:
+ *  - num_acquired: direct access buffers acquired and not yet released
+ *  - num_active: streams which are activated
+ *  - num_sensor_reads: sensor reads so far, including this one
+ *  - num_tx_elems: elements written to transmit streams with writeStream
+ *  - num_tx_ramp: written elements which continued the ramp without a break
+ *  - num_instances: mock devices of the process which are open
+ *  - num_queries: calls of the frequency and sample rate getters and ranges so far
+ *  - lo_locked: per-channel, always true
+ *
+ * Clocking and time:
+ *  - the clock and time sources are "internal" until set to "internal" or "external"
+ *  - the setting "hardware_time" reads the hardware time of the device
+ *  - the setting "command_time" reads the time of setCommandTime, 0 when cleared
+ *  - the per-channel setting "tune_time" reads the command time of the last setFrequency
+ *
+ * Streaming:
+ *  - the setting "num_stream_reads" reads the readStream calls so far
+ *  - the setting "num_status_reads" reads the readStreamStatus calls so far
+ *
+ * Registers:
+ *  - the interface "regs" and the un-named registers share one register file, zero until written
+ *
+ * Discovery args:
+ *  - find_count: number of devices found, with the serials 0 to find_count-1
+ *    (default one device without a serial)
+ *  - every result has num_finds: the discovery calls of the process so far, including this one
+ *
+ * The driver is registered as "multimock" by the executables
+ * which compile this file, it is not part of the support module.
+ **********************************************************************/
+
+#include <SoapySDR/Device.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Registry.hpp>
+#include <SoapySDR/Time.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+//! Mock devices of the process which are open
+static std::atomic<long> numMockInstances(0);
+
+//! Discovery calls of the process
+static std::atomic<long> numMockFinds(0);
+
+struct SoapyMultiMockStream
+{
+    int direction;
+    bool cs16;
+    size_t elemSize;
+    std::vector<size_t> channels;
+    bool active;
+    long long startNs; //hardware time of a timed activation
+    long long ticks;
+    unsigned long long numElemsTotal;
+    std::minstd_rand rng;
+    std::atomic<size_t> numBurstAcks;
+
+    //direct access buffers, one per channel for each handle
+    std::vector<std::vector<std::vector<char>>> buffs;
+    std::vector<bool> acquired;
+    size_t nextHandle;
+};
+
+class SoapyMultiMock : public SoapySDR::Device
+{
+public:
+    SoapyMultiMock(const SoapySDR::Kwargs &args):
+        _numChannels(std::stoul(getArg(args, "channels", "1"))),
+        _mtu(std::stoul(getArg(args, "mtu", "1024"))),
+        _latencyUs(std::stol(getArg(args, "latency_us", "0"))),
+        _jitterUs(std::stol(getArg(args, "jitter_us", "0"))),
+        _shortReads(std::stod(getArg(args, "short_reads", "0"))),
+        _numBuffs(std::stoul(getArg(args, "num_buffs", "8"))),
+        _ticks(std::stoll(getArg(args, "ticks", "0"))),
+        _activateRet(std::stoi(getArg(args, "activate_ret", "0"))),
+        _timedStop(getArg(args, "timed_stop", "true") == "true"),
+        _sensorUs(std::stol(getArg(args, "sensor_us", "0"))),
+        _registerUs(std::stol(getArg(args, "register_us", "0"))),
+        _readError(std::stoi(getArg(args, "read_error", "0"))),
+        _statusError(std::stoi(getArg(args, "status_error", "0"))),
+        _timedTune(getArg(args, "timed_tune", "false") == "true"),
+        _rate(std::stod(getArg(args, "rate", "1e6"))),
+        _timeOffsetNs(0),
+        _clockSource("internal"),
+        _timeSource("internal"),
+        _commandTimeNs(0),
+        _numAcquired(0),
+        _numActive(0),
+        _numSensorReads(0),
+        _numTxElems(0),
+        _numQueries(0),
+        _numTxRamp(0),
+        _txRampBroken(false),
+        _numStreamReads(0),
+        _numStatusReads(0)
+    {
+        if (_numChannels == 0) throw std::runtime_error("SoapyMultiMock() -- channels must be non-zero");
+        if (_mtu == 0) throw std::runtime_error("SoapyMultiMock() -- mtu must be non-zero");
+        if (_numBuffs == 0) throw std::runtime_error("SoapyMultiMock() -- num_buffs must be non-zero");
+        if (getArg(args, "make_error", "false") == "true") throw std::runtime_error("SoapyMultiMock() -- make_error");
+        numMockInstances++;
+    }
+
+    ~SoapyMultiMock(void)
+    {
+        numMockInstances--;
+    }
+
+    /*******************************************************************
+     * Identification API
+     ******************************************************************/
+
+    std::string getDriverKey(void) const
+    {
+        return "multimock";
+    }
+
+    std::string getHardwareKey(void) const
+    {
+        return "multimock";
+    }
+
+    /*******************************************************************
+     * Channels API
+     ******************************************************************/
+
+    size_t getNumChannels(const int) const
+    {
+        return _numChannels;
+    }
+
+    bool getFullDuplex(const int, const size_t) const
+    {
+        return true;
+    }
+
+    /*******************************************************************
+     * Stream API
+     ******************************************************************/
+
+    std::vector<std::string> getStreamFormats(const int, const size_t) const
+    {
+        return {SOAPY_SDR_CF32, SOAPY_SDR_CS16};
+    }
+
+    std::string getNativeStreamFormat(const int, const size_t, double &fullScale) const
+    {
+        fullScale = 32768;
+        return SOAPY_SDR_CS16;
+    }
+
+    SoapySDR::Stream *setupStream(
+        const int direction,
+        const std::string &format,
+        const std::vector<size_t> &channels,
+        const SoapySDR::Kwargs &)
+    {
+        if (format != SOAPY_SDR_CF32 and format != SOAPY_SDR_CS16)
+        {
+            throw std::runtime_error("SoapyMultiMock::setupStream() -- unsupported format " + format);
+        }
+
+        for (const auto channel : channels)
+        {
+            if (channel >= _numChannels) throw std::runtime_error("SoapyMultiMock::setupStream() -- channel out of range");
+        }
+
+        auto stream = new SoapyMultiMockStream();
+        stream->direction = direction;
+        stream->cs16 = (format == SOAPY_SDR_CS16);
+        stream->elemSize = SoapySDR::formatToSize(format);
+        stream->channels = channels.empty()?std::vector<size_t>(1, 0):channels;
+        stream->active = false;
+        stream->startNs = std::numeric_limits<long long>::min();
+        stream->ticks = _ticks;
+        stream->numElemsTotal = 0;
+        stream->numBurstAcks = 0;
+        stream->nextHandle = 0;
+        stream->acquired.resize(_numBuffs, false);
+        stream->buffs.resize(_numBuffs);
+        for (auto &buffs : stream->buffs)
+        {
+            buffs.resize(stream->channels.size(), std::vector<char>(_mtu*stream->elemSize));
+        }
+
+        return reinterpret_cast<SoapySDR::Stream *>(stream);
+    }
+
+    void closeStream(SoapySDR::Stream *stream)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        for (const bool acquired : mockStream->acquired) if (acquired) _numAcquired--;
+        delete mockStream;
+    }
+
+    size_t getStreamMTU(SoapySDR::Stream *) const
+    {
+        return _mtu;
+    }
+
+    int activateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs, const size_t)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (_activateRet != 0) return _activateRet;
+        if ((flags & SOAPY_SDR_HAS_TIME) != 0)
+        {
+            mockStream->startNs = timeNs;
+            mockStream->ticks = SoapySDR::timeNsToTicks(timeNs, this->getSampleRate(mockStream->direction, 0));
+        }
+        if (not mockStream->active) _numActive++;
+        mockStream->active = true;
+        return 0;
+    }
+
+    int deactivateStream(SoapySDR::Stream *stream, const int flags, const long long)
+    {
+        if (not _timedStop and (flags & SOAPY_SDR_HAS_TIME) != 0) return SOAPY_SDR_NOT_SUPPORTED;
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (mockStream->active) _numActive--;
+        mockStream->active = false;
+        return 0;
+    }
+
+    int readStream(
+        SoapySDR::Stream *stream,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        _numStreamReads++;
+        if (not mockStream->active) return this->idle(timeoutUs);
+        if (_readError != 0) return _readError;
+        if (not this->started(*mockStream, timeoutUs)) return SOAPY_SDR_TIMEOUT;
+        if (not this->delay(*mockStream, timeoutUs)) return SOAPY_SDR_TIMEOUT;
+
+        const size_t n = this->limit(*mockStream, numElems);
+        this->generate(*mockStream, buffs, n, flags, timeNs);
+        return int(n);
+    }
+
+    int writeStream(
+        SoapySDR::Stream *stream,
+        const void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        const long long,
+        const long timeoutUs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (not mockStream->active) return this->idle(timeoutUs);
+        if (not this->delay(*mockStream, timeoutUs)) return SOAPY_SDR_TIMEOUT;
+
+        const size_t n = this->limit(*mockStream, numElems);
+        this->checkRamp(*mockStream, buffs[0], n);
+        mockStream->numElemsTotal += n;
+        if ((flags & SOAPY_SDR_END_BURST) != 0 and n == numElems) mockStream->numBurstAcks++;
+        flags = 0;
+        return int(n);
+    }
+
+    int readStreamStatus(
+        SoapySDR::Stream *stream,
+        size_t &chanMask,
+        int &flags,
+        long long &,
+        const long timeoutUs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        _numStatusReads++;
+        if (mockStream->direction != SOAPY_SDR_TX) return SOAPY_SDR_NOT_SUPPORTED;
+        if (_statusError != 0) return _statusError;
+
+        //poll for a burst ack until the timeout
+        const auto exitTime = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+        while (mockStream->numBurstAcks == 0)
+        {
+            if (std::chrono::steady_clock::now() > exitTime) return SOAPY_SDR_TIMEOUT;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        mockStream->numBurstAcks--;
+        chanMask = (size_t(1) << mockStream->channels.size()) - 1;
+        flags = SOAPY_SDR_END_BURST;
+        return 0;
+    }
+
+    /*******************************************************************
+     * Direct buffer access API
+     ******************************************************************/
+
+    size_t getNumDirectAccessBuffers(SoapySDR::Stream *)
+    {
+        return _numBuffs;
+    }
+
+    int getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (handle >= mockStream->buffs.size()) return SOAPY_SDR_NOT_SUPPORTED;
+        for (size_t i = 0; i < mockStream->channels.size(); i++)
+        {
+            buffs[i] = mockStream->buffs[handle][i].data();
+        }
+        return 0;
+    }
+
+    int acquireReadBuffer(
+        SoapySDR::Stream *stream,
+        size_t &handle,
+        const void **buffs,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (not mockStream->active) return this->idle(timeoutUs);
+        if (not this->delay(*mockStream, timeoutUs)) return SOAPY_SDR_TIMEOUT;
+
+        std::vector<void *> outs(mockStream->channels.size());
+        if (not this->nextHandle(*mockStream, handle, outs.data())) return this->idle(timeoutUs);
+        const size_t n = this->limit(*mockStream, _mtu);
+        this->generate(*mockStream, outs.data(), n, flags, timeNs);
+        std::copy(outs.begin(), outs.end(), buffs);
+        return int(n);
+    }
+
+    void releaseReadBuffer(SoapySDR::Stream *stream, const size_t handle)
+    {
+        this->release(*reinterpret_cast<SoapyMultiMockStream *>(stream), handle);
+    }
+
+    int acquireWriteBuffer(
+        SoapySDR::Stream *stream,
+        size_t &handle,
+        void **buffs,
+        const long timeoutUs)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        if (not mockStream->active) return this->idle(timeoutUs);
+        if (not this->delay(*mockStream, timeoutUs)) return SOAPY_SDR_TIMEOUT;
+
+        if (not this->nextHandle(*mockStream, handle, buffs)) return this->idle(timeoutUs);
+        return int(_mtu);
+    }
+
+    void releaseWriteBuffer(
+        SoapySDR::Stream *stream,
+        const size_t handle,
+        const size_t numElems,
+        int &flags,
+        const long long)
+    {
+        auto mockStream = reinterpret_cast<SoapyMultiMockStream *>(stream);
+        this->release(*mockStream, handle);
+        mockStream->numElemsTotal += numElems;
+        flags = 0;
+    }
+
+    /*******************************************************************
+     * Sensor API
+     ******************************************************************/
+
+    std::vector<std::string> listSensors(void) const
+    {
+        return {"num_acquired", "num_active", "num_sensor_reads", "num_tx_elems", "num_tx_ramp", "num_instances", "num_queries"};
+    }
+
+    std::string readSensor(const std::string &name) const
+    {
+        const auto numReads = this->sensorRead();
+        if (name == "num_acquired") return std::to_string(_numAcquired.load());
+        if (name == "num_active") return std::to_string(_numActive.load());
+        if (name == "num_sensor_reads") return std::to_string(numReads);
+        if (name == "num_tx_elems") return std::to_string(_numTxElems.load());
+        if (name == "num_tx_ramp") return std::to_string(_numTxRamp.load());
+        if (name == "num_instances") return std::to_string(numMockInstances.load());
+        if (name == "num_queries") return std::to_string(_numQueries.load());
+        throw std::runtime_error("SoapyMultiMock::readSensor() -- unknown sensor " + name);
+    }
+
+    std::vector<std::string> listSensors(const int, const size_t) const
+    {
+        return {"lo_locked"};
+    }
+
+    std::string readSensor(const int, const size_t channel, const std::string &name) const
+    {
+        this->sensorRead();
+        if (channel >= _numChannels) throw std::runtime_error("SoapyMultiMock::readSensor() -- bad channel");
+        if (name == "lo_locked") return "true";
+        throw std::runtime_error("SoapyMultiMock::readSensor() -- unknown sensor " + name);
+    }
+
+    //! Count the sensor read and wait out the sensor delay
+    long sensorRead(void) const
+    {
+        if (_sensorUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(_sensorUs));
+        return ++_numSensorReads;
+    }
+
+    /*******************************************************************
+     * Register API
+     ******************************************************************/
+
+    std::vector<std::string> listRegisterInterfaces(void) const
+    {
+        return {"regs"};
+    }
+
+    void writeRegister(const std::string &name, const unsigned addr, const unsigned value)
+    {
+        this->writeRegisters(name, addr, {value});
+    }
+
+    unsigned readRegister(const std::string &name, const unsigned addr) const
+    {
+        return this->readRegisters(name, addr, 1).at(0);
+    }
+
+    void writeRegister(const unsigned addr, const unsigned value)
+    {
+        this->writeRegisters("regs", addr, {value});
+    }
+
+    unsigned readRegister(const unsigned addr) const
+    {
+        return this->readRegisters("regs", addr, 1).at(0);
+    }
+
+    void writeRegisters(const std::string &name, const unsigned addr, const std::vector<unsigned> &value)
+    {
+        if (name != "regs") throw std::runtime_error("SoapyMultiMock::writeRegisters() -- unknown interface " + name);
+        if (_registerUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(_registerUs));
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < value.size(); i++) _registers[addr+unsigned(i)] = value[i];
+    }
+
+    std::vector<unsigned> readRegisters(const std::string &name, const unsigned addr, const size_t length) const
+    {
+        if (name != "regs") throw std::runtime_error("SoapyMultiMock::readRegisters() -- unknown interface " + name);
+        if (_registerUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(_registerUs));
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<unsigned> value(length, 0);
+        for (size_t i = 0; i < length; i++)
+        {
+            const auto it = _registers.find(addr+unsigned(i));
+            if (it != _registers.end()) value[i] = it->second;
+        }
+        return value;
+    }
+
+    /*******************************************************************
+     * Frequency API
+     ******************************************************************/
+
+    void setFrequency(const int direction, const size_t channel, const double frequency, const SoapySDR::Kwargs &)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto key = std::make_pair(direction, channel);
+        _tuneTimes[key] = _commandTimeNs;
+        if (_timedTune and _commandTimeNs != 0) _timedTunes[key] = std::make_pair(_commandTimeNs, frequency);
+        else _frequencies[key] = frequency;
+    }
+
+    double getFrequency(const int direction, const size_t channel) const
+    {
+        _numQueries++;
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        //apply the queued tunes whose command time has passed
+        const long long timeNs = this->nowNs() + _timeOffsetNs;
+        for (auto it = _timedTunes.begin(); it != _timedTunes.end();)
+        {
+            if (it->second.first > timeNs) ++it;
+            else
+            {
+                _frequencies[it->first] = it->second.second;
+                it = _timedTunes.erase(it);
+            }
+        }
+
+        auto it = _frequencies.find(std::make_pair(direction, channel));
+        return (it == _frequencies.end())?0.0:it->second;
+    }
+
+    SoapySDR::RangeList getFrequencyRange(const int, const size_t) const
+    {
+        _numQueries++;
+        return SoapySDR::RangeList(1, SoapySDR::Range(0.0, 6e9));
+    }
+
+    /*******************************************************************
+     * Sample Rate API
+     ******************************************************************/
+
+    void setSampleRate(const int, const size_t, const double rate)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rate = rate;
+    }
+
+    double getSampleRate(const int, const size_t) const
+    {
+        _numQueries++;
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _rate;
+    }
+
+    SoapySDR::RangeList getSampleRateRange(const int, const size_t) const
+    {
+        _numQueries++;
+        return SoapySDR::RangeList(1, SoapySDR::Range(1e3, 100e6));
+    }
+
+    /*******************************************************************
+     * Clocking API
+     ******************************************************************/
+
+    std::vector<std::string> listClockSources(void) const
+    {
+        return {"internal", "external"};
+    }
+
+    void setClockSource(const std::string &source)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clockSource = checkSource(source);
+    }
+
+    std::string getClockSource(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _clockSource;
+    }
+
+    /*******************************************************************
+     * Time API
+     ******************************************************************/
+
+    std::vector<std::string> listTimeSources(void) const
+    {
+        return {"internal", "external"};
+    }
+
+    void setTimeSource(const std::string &source)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _timeSource = checkSource(source);
+    }
+
+    std::string getTimeSource(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _timeSource;
+    }
+
+    bool hasHardwareTime(const std::string &what) const
+    {
+        return what.empty();
+    }
+
+    long long getHardwareTime(const std::string &) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return this->nowNs() + _timeOffsetNs;
+    }
+
+    void setHardwareTime(const long long timeNs, const std::string &)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _timeOffsetNs = timeNs - this->nowNs();
+    }
+
+    void setCommandTime(const long long timeNs, const std::string &)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _commandTimeNs = timeNs;
+    }
+
+    /*******************************************************************
+     * Settings API
+     ******************************************************************/
+
+    std::string readSetting(const std::string &key) const
+    {
+        if (key == "hardware_time") return std::to_string(this->getHardwareTime(""));
+        if (key == "num_stream_reads") return std::to_string(_numStreamReads.load());
+        if (key == "num_status_reads") return std::to_string(_numStatusReads.load());
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (key == "command_time") return std::to_string(_commandTimeNs);
+        throw std::runtime_error("SoapyMultiMock::readSetting() -- unknown setting " + key);
+    }
+
+    std::string readSetting(const int direction, const size_t channel, const std::string &key) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (key != "tune_time") throw std::runtime_error("SoapyMultiMock::readSetting() -- unknown setting " + key);
+        auto it = _tuneTimes.find(std::make_pair(direction, channel));
+        return std::to_string((it == _tuneTimes.end())?0:it->second);
+    }
+
+private:
+    static const std::string &checkSource(const std::string &source)
+    {
+        if (source != "internal" and source != "external") throw std::runtime_error("SoapyMultiMock -- unknown source " + source);
+        return source;
+    }
+
+    static std::string getArg(const SoapySDR::Kwargs &args, const std::string &key, const std::string &def)
+    {
+        auto it = args.find(key);
+        return (it == args.end())?def:it->second;
+    }
+
+    long long nowNs(void) const
+    {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    }
+
+    //an inactive stream waits out the timeout like a real device
+    int idle(const long timeoutUs)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeoutUs));
+        return SOAPY_SDR_TIMEOUT;
+    }
+
+    //wait for the start time of a timed activation, false when it is past the timeout
+    bool started(SoapyMultiMockStream &stream, const long timeoutUs)
+    {
+        const long long nowNs = this->getHardwareTime("");
+        if (stream.startNs <= nowNs) return true;
+        const long long waitNs = stream.startNs - nowNs;
+        if (waitNs > timeoutUs*1000LL)
+        {
+            this->idle(timeoutUs);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+        return true;
+    }
+
+    //simulate the transport latency of one call, false when it exceeds the timeout
+    bool delay(SoapyMultiMockStream &stream, const long timeoutUs)
+    {
+        long delayUs = _latencyUs;
+        if (_jitterUs > 0) delayUs += long(stream.rng() % (unsigned long)(_jitterUs+1));
+        if (delayUs > timeoutUs)
+        {
+            this->idle(std::max(timeoutUs, 0L));
+            return false;
+        }
+        if (delayUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+        return true;
+    }
+
+    //limit the number of elements to the mtu and apply short reads
+    size_t limit(SoapyMultiMockStream &stream, const size_t numElems)
+    {
+        size_t n = std::min(numElems, _mtu);
+        if (n > 1 and _shortReads > 0.0)
+        {
+            std::uniform_real_distribution<double> dist(0.0, 1.0);
+            if (dist(stream.rng) < _shortReads) n = 1 + stream.rng() % (n-1);
+        }
+        return n;
+    }
+
+    //acquire the next buffer in order, false when it was not released yet
+    bool nextHandle(SoapyMultiMockStream &stream, size_t &handle, void **buffs)
+    {
+        handle = stream.nextHandle;
+        if (stream.acquired[handle]) return false;
+        stream.acquired[handle] = true;
+        _numAcquired++;
+        stream.nextHandle = (handle+1) % stream.buffs.size();
+        this->getDirectAccessBufferAddrs(reinterpret_cast<SoapySDR::Stream *>(&stream), handle, buffs);
+        return true;
+    }
+
+    void release(SoapyMultiMockStream &stream, const size_t handle)
+    {
+        if (handle >= stream.acquired.size() or not stream.acquired[handle]) return;
+        stream.acquired[handle] = false;
+        _numAcquired--;
+    }
+
+    void generate(SoapyMultiMockStream &stream, void * const *buffs, const size_t n, int &flags, long long &timeNs)
+    {
+        for (size_t i = 0; i < stream.channels.size(); i++)
+        {
+            const auto channel = stream.channels[i];
+            if (stream.cs16)
+            {
+                auto out = reinterpret_cast<int16_t *>(buffs[i]);
+                for (size_t j = 0; j < n; j++)
+                {
+                    out[j*2+0] = int16_t((stream.ticks+j) & 0x7fff);
+                    out[j*2+1] = int16_t(channel);
+                }
+            }
+            else
+            {
+                auto out = reinterpret_cast<float *>(buffs[i]);
+                for (size_t j = 0; j < n; j++)
+                {
+                    out[j*2+0] = float((stream.ticks+j) & 0x7fff);
+                    out[j*2+1] = float(channel);
+                }
+            }
+        }
+
+        flags = SOAPY_SDR_HAS_TIME;
+        timeNs = SoapySDR::ticksToTimeNs(stream.ticks, this->getSampleRate(stream.direction, 0));
+        stream.ticks += n;
+        stream.numElemsTotal += n;
+    }
+
+    //count the written elements and how far they continue the ramp
+    void checkRamp(const SoapyMultiMockStream &stream, const void *buff, const size_t n)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t j = 0; j < n and not _txRampBroken; j++)
+        {
+            const long long real = stream.cs16?
+                reinterpret_cast<const int16_t *>(buff)[j*2]:
+                (long long)(reinterpret_cast<const float *>(buff)[j*2]);
+            if (real == (_numTxRamp & 0x7fff)) _numTxRamp++;
+            else _txRampBroken = true;
+        }
+        _numTxElems += n;
+    }
+
+    const size_t _numChannels;
+    const size_t _mtu;
+    const long _latencyUs;
+    const long _jitterUs;
+    const double _shortReads;
+    const size_t _numBuffs;
+    const long long _ticks;
+    const int _activateRet;
+    const bool _timedStop;
+    const long _sensorUs;
+    const long _registerUs;
+    const int _readError;
+    const int _statusError;
+    const bool _timedTune;
+
+    mutable std::mutex _mutex;
+    double _rate;
+    long long _timeOffsetNs;
+    std::string _clockSource;
+    std::string _timeSource;
+    long long _commandTimeNs;
+    mutable std::map<std::pair<int, size_t>, double> _frequencies;
+    mutable std::map<std::pair<int, size_t>, std::pair<long long, double>> _timedTunes; //command time and frequency
+    std::map<std::pair<int, size_t>, long long> _tuneTimes;
+    std::map<unsigned, unsigned> _registers;
+    std::atomic<long> _numAcquired;
+    std::atomic<long> _numActive;
+    mutable std::atomic<long> _numSensorReads;
+    std::atomic<long long> _numTxElems;
+    mutable std::atomic<long> _numQueries;
+    std::atomic<long long> _numTxRamp;
+    bool _txRampBroken;
+    std::atomic<long> _numStreamReads;
+    std::atomic<long> _numStatusReads;
+};
+
+/***********************************************************************
+ * Registration -- only yield results when the driver is requested
+ **********************************************************************/
+static SoapySDR::KwargsList findMultiMock(const SoapySDR::Kwargs &args)
+{
+    SoapySDR::KwargsList result;
+    if (args.count("driver") == 0 or args.at("driver") != "multimock") return result;
+
+    SoapySDR::Kwargs mockArgs(args);
+    mockArgs["label"] = "Multi Mock Device";
+    mockArgs["num_finds"] = std::to_string(++numMockFinds);
+    if (args.count("find_count") == 0)
+    {
+        result.push_back(mockArgs);
+        return result;
+    }
+
+    for (size_t i = 0; i < std::stoul(args.at("find_count")); i++)
+    {
+        mockArgs["serial"] = std::to_string(i);
+        result.push_back(mockArgs);
+    }
+    return result;
+}
+
+static SoapySDR::Device *makeMultiMock(const SoapySDR::Kwargs &args)
+{
+    return new SoapyMultiMock(args);
+}
+
+static SoapySDR::Registry registerMultiMock("multimock", &findMultiMock, &makeMultiMock, SOAPY_SDR_ABI_VERSION);
@@ -78,3 +78,68 @@ static inline std::string csvJoin(const std::vector<std::string> &in)
     }
     return out;
 }
+
+/*!
+ * Split a name which selects several indexes into internal name and indexes:
+ * name[*] selects every index below numIndexes, name[i,j,k] the listed indexes in that order,
+ * and name[index] the one index. Throws for another format, a repeated index, or an index out of range.
+ */
+static inline std::string splitIndexedNames(const std::string &inName, const size_t numIndexes, std::vector<size_t> &indexes)
+{
+    const std::string error("splitIndexedNames("+inName+") ");
+    const size_t openBracketPos = inName.find_last_of("[");
+    const size_t closeBracketPos = inName.find_last_of("]");
+    if (openBracketPos == std::string::npos or closeBracketPos == std::string::npos or closeBracketPos < openBracketPos)
+    {
+        throw std::runtime_error(error+"not in name[index], name[index,index] or name[*] format");
+    }
+
+    indexes.clear();
+    const auto selection = inName.substr(openBracketPos+1, closeBracketPos-openBracketPos-1);
+    if (selection == "*")
+    {
+        for (size_t i = 0; i < numIndexes; i++) indexes.push_back(i);
+        return inName.substr(0, openBracketPos);
+    }
+
+    for (const auto &indexStr : csvSplit(selection))
+    {
+        if (indexStr.empty()) throw std::runtime_error(error+"empty index");
+        for (const auto &ch : indexStr)
+        {
+            if (not std::isdigit(ch)) throw std::runtime_error(error+"bad index "+indexStr);
+        }
+        const size_t index = std::stoul(indexStr);
+        if (index >= numIndexes) throw std::runtime_error(error+"index out of range "+indexStr);
+        for (const auto other : indexes)
+        {
+            if (other == index) throw std::runtime_error(error+"repeated index "+indexStr);
+        }
+        indexes.push_back(index);
+    }
+    if (indexes.empty()) throw std::runtime_error(error+"selects no index");
+    return inName.substr(0, openBracketPos);
+}
+
+//! Quote a string as a JSON string value, escaping quotes, backslashes and control characters
+static inline std::string jsonQuote(const std::string &in)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string out("\"");
+    for (const auto &ch : in)
+    {
+        if (ch == '"') out += "\\\"";
+        else if (ch == '\\') out += "\\\\";
+        else if (ch == '\n') out += "\\n";
+        else if (ch == '\r') out += "\\r";
+        else if (ch == '\t') out += "\\t";
+        else if ((unsigned char)(ch) < 0x20)
+        {
+            out += "\\u00";
+            out += hex[(ch >> 4) & 0xf];
+            out += hex[ch & 0xf];
+        }
+        else out += ch;
+    }
+    return out + "\"";
+}
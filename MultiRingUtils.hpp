@@ -0,0 +1,166 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+/*!
+ * A fixed capacity lock-free queue for one producer and one consumer thread.
+ * The producer calls push(), the consumer calls empty(), front() and pop().
+ */
+template <typename Type>
+class SoapyMultiQueue
+{
+public:
+    SoapyMultiQueue(const size_t capacity):
+        _items(capacity),
+        _writeIndex(0),
+        _readIndex(0)
+    {
+        return;
+    }
+
+    //! Push an item from the producer thread, false when the queue is full
+    bool push(const Type &item)
+    {
+        const size_t index = _writeIndex.load(std::memory_order_relaxed);
+        if (index - _readIndex.load(std::memory_order_acquire) == _items.size()) return false;
+        _items[index % _items.size()] = item;
+        _writeIndex.store(index+1, std::memory_order_release);
+        return true;
+    }
+
+    //! True when there are no items for the consumer thread
+    bool empty(void) const
+    {
+        return _readIndex.load(std::memory_order_relaxed) == _writeIndex.load(std::memory_order_acquire);
+    }
+
+    //! The oldest item, only valid when not empty
+    const Type &front(void) const
+    {
+        return _items[_readIndex.load(std::memory_order_relaxed) % _items.size()];
+    }
+
+    //! Remove the oldest item from the consumer thread
+    void pop(void)
+    {
+        _readIndex.store(_readIndex.load(std::memory_order_relaxed)+1, std::memory_order_release);
+    }
+
+    //! Remove all items, only when neither thread is using the queue
+    void clear(void)
+    {
+        _writeIndex = 0;
+        _readIndex = 0;
+    }
+
+private:
+    std::vector<Type> _items;
+    std::atomic<size_t> _writeIndex;
+    std::atomic<size_t> _readIndex;
+};
+
+/*!
+ * A lock-free ring of multi-channel elements for one producer and one consumer thread.
+ * The read and write indexes count elements since the last reset,
+ * so the data at an index has the same position in every channel.
+ * The producer writes directly into the contiguous space at the write index
+ * and then publishes the elements with commit().
+ */
+class SoapyMultiRing
+{
+public:
+    SoapyMultiRing(const size_t numChannels, const size_t elemSize, const size_t capacity):
+        _elemSize(elemSize),
+        _capacity(capacity),
+        _buffs(numChannels, std::vector<char>(capacity*elemSize)),
+        _writeIndex(0),
+        _readIndex(0)
+    {
+        return;
+    }
+
+    size_t capacity(void) const
+    {
+        return _capacity;
+    }
+
+    //! Forget all elements, only when neither thread is using the ring
+    void reset(void)
+    {
+        _writeIndex = 0;
+        _readIndex = 0;
+    }
+
+    /*******************************************************************
+     * Producer API
+     ******************************************************************/
+
+    //! The index of the next element which will be written
+    unsigned long long writeIndex(void) const
+    {
+        return _writeIndex.load(std::memory_order_relaxed);
+    }
+
+    //! Get pointers to the contiguous free space, \return the number of free elements
+    size_t writeBuffs(void **buffs) const
+    {
+        const auto index = _writeIndex.load(std::memory_order_relaxed);
+        const size_t numFree = _capacity - size_t(index - _readIndex.load(std::memory_order_acquire));
+        const size_t offset = size_t(index % _capacity);
+        for (size_t ch = 0; ch < _buffs.size(); ch++)
+        {
+            buffs[ch] = const_cast<char *>(_buffs[ch].data()) + offset*_elemSize;
+        }
+        return std::min(numFree, _capacity - offset);
+    }
+
+    //! Publish the elements written into the free space
+    void commit(const size_t numElems)
+    {
+        _writeIndex.store(_writeIndex.load(std::memory_order_relaxed)+numElems, std::memory_order_release);
+    }
+
+    /*******************************************************************
+     * Consumer API
+     ******************************************************************/
+
+    //! The index of the next element which will be read
+    unsigned long long readIndex(void) const
+    {
+        return _readIndex.load(std::memory_order_relaxed);
+    }
+
+    //! The number of elements available to read
+    size_t readable(void) const
+    {
+        return size_t(_writeIndex.load(std::memory_order_acquire) - _readIndex.load(std::memory_order_relaxed));
+    }
+
+    //! Copy out and release numElems elements, numElems must be readable
+    void read(void * const *buffs, const size_t numElems)
+    {
+        const auto index = _readIndex.load(std::memory_order_relaxed);
+        const size_t offset = size_t(index % _capacity);
+        const size_t numFirst = std::min(numElems, _capacity - offset);
+        for (size_t ch = 0; ch < _buffs.size(); ch++)
+        {
+            auto out = static_cast<char *>(buffs[ch]);
+            std::memcpy(out, _buffs[ch].data() + offset*_elemSize, numFirst*_elemSize);
+            std::memcpy(out + numFirst*_elemSize, _buffs[ch].data(), (numElems-numFirst)*_elemSize);
+        }
+        _readIndex.store(index+numElems, std::memory_order_release);
+    }
+
+private:
+    const size_t _elemSize;
+    const size_t _capacity;
+    std::vector<std::vector<char>> _buffs;
+    std::atomic<unsigned long long> _writeIndex;
+    std::atomic<unsigned long long> _readIndex;
+};
@@ -0,0 +1,187 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Measure the overhead of the multi-device wrapper with mock devices.
+ * The wrapper sources and the mock driver are compiled into this
+ * executable, so the benchmark does not depend on installed modules.
+ *
+ * Usage: MultiSDRBench [--key=value]...
+ *  --devices: number of mock devices (default 2)
+ *  --channels: channels per mock device (default 1)
+ *  --format: stream format (default CF32)
+ *  --elems: elements per stream call (default 4096)
+ *  --seconds: duration of each test (default 1.0)
+ *  --tests: comma separated list of rx, tx, direct_rx, direct_tx (default all)
+ *  --args: extra mock device args, ex: "mtu=1500, jitter_us=10"
+ *  --options: wrapper options, ex: "make_threads=4"
+ *  --stream_args: stream args, ex: "multi:parallel=true"
+ **********************************************************************/
+
+#include "SoapyMultiSDR.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+
+struct SoapyMultiBenchResult
+{
+    unsigned long long numElems;
+    size_t numCalls;
+    size_t numErrors;
+    double seconds;
+    double cpuSeconds;
+    std::vector<double> latenciesUs;
+};
+
+static void printResult(const std::string &name, SoapyMultiBenchResult &result)
+{
+    auto &latencies = result.latenciesUs;
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](const double p)
+    {
+        if (latencies.empty()) return 0.0;
+        return latencies[std::min(latencies.size()-1, size_t(p*latencies.size()))];
+    };
+
+    std::printf("%-10s %12.3f Msps %8zu calls %6zu errors  latency us p50 %8.1f p90 %8.1f p99 %8.1f max %8.1f  cpu %6.1f%%\n",
+        name.c_str(),
+        result.numElems/result.seconds/1e6,
+        result.numCalls,
+        result.numErrors,
+        percentile(0.50),
+        percentile(0.90),
+        percentile(0.99),
+        latencies.empty()?0.0:latencies.back(),
+        100.0*result.cpuSeconds/result.seconds);
+}
+
+static SoapyMultiBenchResult runTest(
+    SoapySDR::Device *device,
+    const std::string &test,
+    const std::string &format,
+    const size_t numElems,
+    const double seconds,
+    const SoapySDR::Kwargs &streamArgs)
+{
+    const bool isRx = (test == "rx" or test == "direct_rx");
+    const bool isDirect = (test == "direct_rx" or test == "direct_tx");
+    const int direction = isRx?SOAPY_SDR_RX:SOAPY_SDR_TX;
+
+    std::vector<size_t> channels(device->getNumChannels(direction));
+    for (size_t i = 0; i < channels.size(); i++) channels[i] = i;
+
+    //one buffer per channel for the read and write calls
+    const size_t elemSize = SoapySDR::formatToSize(format);
+    std::vector<std::vector<char>> mem(channels.size(), std::vector<char>(numElems*elemSize));
+    std::vector<void *> buffs(channels.size());
+    for (size_t i = 0; i < channels.size(); i++) buffs[i] = mem[i].data();
+
+    auto stream = device->setupStream(direction, format, channels, streamArgs);
+    device->activateStream(stream);
+
+    SoapyMultiBenchResult result;
+    result.numElems = 0;
+    result.numCalls = 0;
+    result.numErrors = 0;
+
+    const auto exitTime = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto startCpu = std::clock();
+    while (true)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        if (t0 > exitTime) break;
+
+        int flags = 0;
+        long long timeNs = 0;
+        size_t handle = 0;
+        int ret = 0;
+        if (isDirect and isRx)
+        {
+            ret = device->acquireReadBuffer(stream, handle, const_cast<const void **>(buffs.data()), flags, timeNs);
+            if (ret >= 0) device->releaseReadBuffer(stream, handle);
+        }
+        else if (isDirect)
+        {
+            ret = device->acquireWriteBuffer(stream, handle, buffs.data());
+            if (ret >= 0) device->releaseWriteBuffer(stream, handle, size_t(ret), flags);
+        }
+        else if (isRx) ret = device->readStream(stream, buffs.data(), numElems, flags, timeNs);
+        else ret = device->writeStream(stream, buffs.data(), numElems, flags);
+
+        const auto t1 = std::chrono::steady_clock::now();
+        result.latenciesUs.push_back(std::chrono::duration<double, std::micro>(t1-t0).count());
+        result.numCalls++;
+        if (ret < 0) result.numErrors++;
+        else result.numElems += ret;
+    }
+    result.cpuSeconds = double(std::clock()-startCpu)/CLOCKS_PER_SEC;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-startTime).count();
+
+    device->deactivateStream(stream);
+    device->closeStream(stream);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    SoapySDR::Kwargs config;
+    config["devices"] = "2";
+    config["channels"] = "1";
+    config["format"] = SOAPY_SDR_CF32;
+    config["elems"] = "4096";
+    config["seconds"] = "1.0";
+    config["tests"] = "rx, tx, direct_rx, direct_tx";
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        const auto eq = arg.find("=");
+        if (arg.find("--") != 0 or eq == std::string::npos)
+        {
+            std::cerr << "Usage: MultiSDRBench [--key=value]..." << std::endl;
+            return EXIT_FAILURE;
+        }
+        config[arg.substr(2, eq-2)] = arg.substr(eq+1);
+    }
+
+    try
+    {
+        const size_t numDevices = std::stoul(config.at("devices"));
+        const size_t numElems = std::stoul(config.at("elems"));
+        const double seconds = std::stod(config.at("seconds"));
+
+        std::vector<SoapySDR::Kwargs> args(numDevices, SoapySDR::KwargsFromString(config["args"]));
+        for (auto &args_i : args)
+        {
+            args_i["driver"] = "multimock";
+            args_i["channels"] = config.at("channels");
+        }
+
+        SoapyMultiSDR device(args, SoapySDR::KwargsFromString(config["options"]));
+        const auto streamArgs = SoapySDR::KwargsFromString(config["stream_args"]);
+
+        std::printf("%zu devices x %s channels, %s, %zu elems per call\n",
+            numDevices, config.at("channels").c_str(), config.at("format").c_str(), numElems);
+        for (const auto &test : csvSplit(config.at("tests")))
+        {
+            if (test != "rx" and test != "tx" and test != "direct_rx" and test != "direct_tx")
+            {
+                throw std::runtime_error("unknown test " + test);
+            }
+            auto result = runTest(&device, test, config.at("format"), numElems, seconds, streamArgs);
+            printResult(test, result);
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "MultiSDRBench failed: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <SoapySDR/Constants.h>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! The last value of a polled sensor and when it was read
+struct SoapyMultiSensorValue
+{
+    std::string value;
+    std::chrono::steady_clock::time_point time;
+};
+
+//! Polled sensor values by poller key
+typedef std::map<std::string, SoapyMultiSensorValue> SoapyMultiSensorValues;
+
+//! The poller key of a per-channel sensor in the format rx<channel>:name
+static inline std::string toChannelSensorKey(const int direction, const size_t channel, const std::string &name)
+{
+    return std::string(direction == SOAPY_SDR_RX ? "rx" : "tx") + std::to_string(channel) + ":" + name;
+}
+
+//! Split the poller key of a per-channel sensor, false when the key is a global sensor name
+static inline bool splitChannelSensorKey(const std::string &key, int &direction, size_t &channel, std::string &name)
+{
+    if (key.compare(0, 2, "rx") == 0) direction = SOAPY_SDR_RX;
+    else if (key.compare(0, 2, "tx") == 0) direction = SOAPY_SDR_TX;
+    else return false;
+
+    const auto colon = key.find(':');
+    if (colon == std::string::npos or colon == 2) return false;
+    for (size_t i = 2; i < colon; i++)
+    {
+        if (not std::isdigit(key[i])) return false;
+    }
+    channel = std::stoul(key.substr(2, colon-2));
+    name = key.substr(colon+1);
+    return true;
+}
+
+/*!
+ * Read the sensors of one device in a background thread at a fixed interval.
+ * Each round of reads is published as a new immutable map through an atomic
+ * shared pointer, so readers never wait on the device or on the poller.
+ * A sensor which fails to read keeps its last value, and the growing age
+ * of that value tells the reader that it is stale.
+ */
+class SoapyMultiSensorPoller
+{
+public:
+    typedef std::function<std::string(const std::string &)> ReadFcn;
+
+    SoapyMultiSensorPoller(const ReadFcn &read):
+        _read(read),
+        _intervalMs(0),
+        _changed(false),
+        _values(std::make_shared<const SoapyMultiSensorValues>())
+    {
+        return;
+    }
+
+    ~SoapyMultiSensorPoller(void)
+    {
+        this->configure(0, {});
+    }
+
+    //! Poll the sensors every interval, an interval of zero stops polling and forgets the values
+    void configure(const long intervalMs, const std::vector<std::string> &sensors)
+    {
+        std::lock_guard<std::mutex> configLock(_configMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _intervalMs = intervalMs;
+            _sensors = sensors;
+            _changed = true;
+        }
+        _cond.notify_one();
+
+        if (intervalMs <= 0 and _thread.joinable())
+        {
+            _thread.join();
+            std::atomic_store(&_values, std::make_shared<const SoapyMultiSensorValues>());
+        }
+        if (intervalMs > 0 and not _thread.joinable())
+        {
+            _thread = std::thread(&SoapyMultiSensorPoller::poll, this);
+        }
+    }
+
+    //! The polling interval, zero when not polling
+    long intervalMs(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _intervalMs;
+    }
+
+    //! The polled sensor keys
+    std::vector<std::string> sensors(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _sensors;
+    }
+
+    //! The values of the last round of reads
+    std::shared_ptr<const SoapyMultiSensorValues> values(void) const
+    {
+        return std::atomic_load(&_values);
+    }
+
+    //! Get the last value of the sensor, false when the sensor is not polled or was never read
+    bool get(const std::string &key, SoapyMultiSensorValue &value) const
+    {
+        const auto values = this->values();
+        const auto it = values->find(key);
+        if (it == values->end()) return false;
+        value = it->second;
+        return true;
+    }
+
+private:
+    void poll(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_intervalMs > 0)
+        {
+            const auto sensors = _sensors;
+            const auto nextTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(_intervalMs);
+            _changed = false;
+            lock.unlock();
+
+            const auto last = this->values();
+            std::shared_ptr<SoapyMultiSensorValues> values(new SoapyMultiSensorValues());
+            for (const auto &key : sensors)
+            {
+                try
+                {
+                    const auto value = _read(key);
+                    (*values)[key] = SoapyMultiSensorValue{value, std::chrono::steady_clock::now()};
+                }
+                catch (const std::exception &)
+                {
+                    const auto it = last->find(key);
+                    if (it != last->end()) values->insert(*it);
+                }
+            }
+            std::atomic_store(&_values, std::shared_ptr<const SoapyMultiSensorValues>(values));
+
+            //a new configuration starts the next round right away
+            lock.lock();
+            _cond.wait_until(lock, nextTime, [this]{return _changed;});
+        }
+    }
+
+    const ReadFcn _read;
+    std::mutex _configMutex; //serializes starting and joining the thread
+    mutable std::mutex _mutex;
+    std::condition_variable _cond;
+    long _intervalMs;
+    std::vector<std::string> _sensors;
+    bool _changed;
+    std::shared_ptr<const SoapyMultiSensorValues> _values;
+    std::thread _thread;
+};
@@ -0,0 +1,103 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <SoapySDR/Constants.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+//! Buckets of the latency histogram, bucket i counts calls under 2^i us and the last bucket the rest
+static const size_t SOAPY_MULTI_LATENCY_BUCKETS = 16;
+
+/*!
+ * Counters of the calls on one sub-stream.
+ * A counter only has one writer at a time, the thread which services the sub-stream,
+ * so an update is a relaxed load and store rather than a locked read-modify-write.
+ * Other threads may read any counter at any time, but the counters
+ * are not a consistent snapshot of each other.
+ */
+class SoapyMultiStats
+{
+public:
+    SoapyMultiStats(void)
+    {
+        for (auto counter : {&calls, &elements, &shortCalls, &timeouts, &overflows, &underflows, &realigns, &dropped, &padded})
+        {
+            counter->store(0, std::memory_order_relaxed);
+        }
+        for (auto skew : {&skewNs, &skewAvgNs, &skewMaxNs}) skew->store(0, std::memory_order_relaxed);
+        for (auto &bucket : latency) bucket.store(0, std::memory_order_relaxed);
+    }
+
+    //! Add n to the counter from the thread which services the sub-stream
+    static void add(std::atomic<unsigned long long> &counter, const unsigned long long n = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    //! Record the result of one call which asked for numElems elements
+    void record(const int ret, const size_t numElems, const long long latencyNs)
+    {
+        add(calls);
+        if (ret > 0) add(elements, (unsigned long long)(ret));
+        if (ret >= 0 and size_t(ret) < numElems) add(shortCalls);
+        if (ret == SOAPY_SDR_TIMEOUT) add(timeouts);
+        if (ret == SOAPY_SDR_OVERFLOW) add(overflows);
+        if (ret == SOAPY_SDR_UNDERFLOW) add(underflows);
+
+        size_t bucket = 0;
+        for (long long us = latencyNs/1000; us != 0 and bucket+1 < SOAPY_MULTI_LATENCY_BUCKETS; us >>= 1) bucket++;
+        add(latency[bucket]);
+    }
+
+    //! Record the timestamp difference of a read against the first sub-stream
+    void recordSkew(const long long skew)
+    {
+        //the average moves 1/16th of the way to each new value
+        const long long avg = skewAvgNs.load(std::memory_order_relaxed);
+        skewNs.store(skew, std::memory_order_relaxed);
+        skewAvgNs.store(avg + (skew - avg)/16, std::memory_order_relaxed);
+        if (std::llabs(skew) > std::llabs(skewMaxNs.load(std::memory_order_relaxed))) skewMaxNs.store(skew, std::memory_order_relaxed);
+    }
+
+    //! The counters as the members of a JSON object, without the braces
+    std::string toJson(void) const
+    {
+        std::string json;
+        json += "\"calls\": " + std::to_string(calls.load(std::memory_order_relaxed));
+        json += ", \"elements\": " + std::to_string(elements.load(std::memory_order_relaxed));
+        json += ", \"short\": " + std::to_string(shortCalls.load(std::memory_order_relaxed));
+        json += ", \"timeouts\": " + std::to_string(timeouts.load(std::memory_order_relaxed));
+        json += ", \"overflows\": " + std::to_string(overflows.load(std::memory_order_relaxed));
+        json += ", \"underflows\": " + std::to_string(underflows.load(std::memory_order_relaxed));
+        json += ", \"realigns\": " + std::to_string(realigns.load(std::memory_order_relaxed));
+        json += ", \"dropped\": " + std::to_string(dropped.load(std::memory_order_relaxed));
+        json += ", \"padded\": " + std::to_string(padded.load(std::memory_order_relaxed));
+        json += ", \"skew_ns\": " + std::to_string(skewNs.load(std::memory_order_relaxed));
+        json += ", \"skew_avg_ns\": " + std::to_string(skewAvgNs.load(std::memory_order_relaxed));
+        json += ", \"skew_max_ns\": " + std::to_string(skewMaxNs.load(std::memory_order_relaxed));
+        json += ", \"latency_us\": [";
+        for (size_t i = 0; i < SOAPY_MULTI_LATENCY_BUCKETS; i++)
+        {
+            if (i != 0) json += ", ";
+            json += std::to_string(latency[i].load(std::memory_order_relaxed));
+        }
+        return json + "]";
+    }
+
+    std::atomic<unsigned long long> calls;
+    std::atomic<unsigned long long> elements;
+    std::atomic<unsigned long long> shortCalls; //fewer elements than requested
+    std::atomic<unsigned long long> timeouts;
+    std::atomic<unsigned long long> overflows;
+    std::atomic<unsigned long long> underflows;
+    std::atomic<unsigned long long> realigns; //reads which dropped elements for alignment
+    std::atomic<unsigned long long> dropped; //elements dropped for alignment
+    std::atomic<unsigned long long> padded; //zeros padded for alignment
+    std::atomic<long long> skewNs; //of the last read
+    std::atomic<long long> skewAvgNs;
+    std::atomic<long long> skewMaxNs; //largest in magnitude
+    std::atomic<unsigned long long> latency[SOAPY_MULTI_LATENCY_BUCKETS];
+};
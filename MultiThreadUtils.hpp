@@ -0,0 +1,164 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+ * A persistent worker thread which runs one posted task at a time.
+ * Post a task with post() and join it with wait(),
+ * any exception thrown by the task is rethrown by wait().
+ */
+class SoapyMultiWorker
+{
+public:
+    SoapyMultiWorker(void):
+        _running(true),
+        _pending(false),
+        _thread(&SoapyMultiWorker::work, this)
+    {
+        return;
+    }
+
+    ~SoapyMultiWorker(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _postCond.notify_one();
+        _thread.join();
+    }
+
+    //! Run the task in the worker thread, only one task may be pending
+    void post(const std::function<void(void)> &task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = task;
+            _pending = true;
+        }
+        _postCond.notify_one();
+    }
+
+    //! Wait for the posted task to complete
+    void wait(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCond.wait(lock, [this]{return not _pending;});
+        if (not _error) return;
+        auto error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+private:
+    void work(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _postCond.wait(lock, [this]{return _pending or not _running;});
+            if (not _pending) return;
+
+            lock.unlock();
+            std::exception_ptr error;
+            try {_task();}
+            catch (...) {error = std::current_exception();}
+            lock.lock();
+
+            _error = error;
+            _pending = false;
+            _doneCond.notify_one();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _postCond;
+    std::condition_variable _doneCond;
+    std::function<void(void)> _task;
+    std::exception_ptr _error;
+    bool _running;
+    bool _pending;
+    std::thread _thread;
+};
+
+//! Combine the errors into one exception, the message lists the index of each error
+static inline void throwErrors(const std::vector<std::exception_ptr> &errors)
+{
+    std::string message;
+    for (size_t i = 0; i < errors.size(); i++)
+    {
+        if (not errors[i]) continue;
+        if (not message.empty()) message += "; ";
+        message += "[" + std::to_string(i) + "] ";
+        try {std::rethrow_exception(errors[i]);}
+        catch (const std::exception &ex) {message += ex.what();}
+        catch (...) {message += "unknown error";}
+    }
+    if (not message.empty()) throw std::runtime_error(message);
+}
+
+/*!
+ * Call the function for every index in [0, count) from up to maxThreads threads,
+ * the calling thread is one of the threads.
+ * Every index is called even when some of the calls throw,
+ * the errors are combined into one exception thrown after all calls complete.
+ */
+static inline void parallelFor(const size_t count, const size_t maxThreads, const std::function<void(const size_t)> &fcn)
+{
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next(0);
+    const auto work = [&](void)
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            try {fcn(i);}
+            catch (...) {errors[i] = std::current_exception();}
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t numThreads = std::min(count, std::max<size_t>(maxThreads, 1));
+    for (size_t i = 1; i < numThreads; i++) threads.emplace_back(work);
+    work();
+    for (auto &thread : threads) thread.join();
+
+    throwErrors(errors);
+}
+
+/*!
+ * A single use barrier for a fixed number of threads.
+ * The threads spin rather than sleep in arrive() so that
+ * they are released as close together as possible.
+ */
+class SoapyMultiBarrier
+{
+public:
+    SoapyMultiBarrier(const size_t count):
+        _count(count),
+        _arrived(0)
+    {
+        return;
+    }
+
+    //! Block until every thread has arrived
+    void arrive(void)
+    {
+        _arrived++;
+        while (_arrived.load() < _count) std::this_thread::yield();
+    }
+
+private:
+    const size_t _count;
+    std::atomic<size_t> _arrived;
+};
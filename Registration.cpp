@@ -2,17 +2,32 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SoapyMultiSDR.hpp"
+#include "MultiThreadUtils.hpp"
 #include <SoapySDR/Registry.hpp>
+#include <SoapySDR/Logger.hpp>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
 
 //! Use this magic stop key in the server to prevent infinite loops
 #define SOAPY_MULTI_KWARG_STOP "soapy_multi_no_deeper"
 
-//! Use this key prefix to pass in args that will become local
-#define SOAPY_MULTI_KWARG_PREFIX "multi:"
+//! Limit on the device combinations returned by one discovery
+static const size_t SOAPY_MULTI_MAX_FIND_RESULTS = 64;
 
 /***********************************************************************
  * Args translator for nested keywords
  **********************************************************************/
+
+//! The keys after the prefix which configure the wrapper itself rather than the devices
+static bool isMultiOption(const std::string &key)
+{
+    static const std::set<std::string> options{
+        "make_threads", "cache_ranges", "cache_getters", "sensor_poll_ms", "enum_cache_ms"};
+    return options.count(key) != 0;
+}
+
 static SoapySDR::Kwargs translateArgs(const SoapySDR::Kwargs &args, const size_t index)
 {
     SoapySDR::Kwargs argsOut;
@@ -32,13 +47,15 @@ static SoapySDR::Kwargs translateArgs(const SoapySDR::Kwargs &args, const size_t
         }
     }
 
-    //write all multi keys with prefix stripped
+    //write all multi keys with prefix stripped, except for the wrapper options
     for (auto &pair : args)
     {
         if (pair.first.find(SOAPY_MULTI_KWARG_PREFIX) == 0)
         {
             static const size_t offset = std::string(SOAPY_MULTI_KWARG_PREFIX).size();
-            argsOut[pair.first.substr(offset)] = pair.second;
+            const auto key = pair.first.substr(offset);
+            if (isMultiOption(key)) continue;
+            argsOut[key] = pair.second;
         }
     }
 
@@ -81,6 +98,121 @@ static std::vector<SoapySDR::Kwargs> translateArgs(const SoapySDR::Kwargs &args)
     return result;
 }
 
+//! The un-indexed args with the prefix which configure the wrapper itself
+static SoapySDR::Kwargs multiOptions(const SoapySDR::Kwargs &args)
+{
+    SoapySDR::Kwargs options;
+    static const size_t offset = std::string(SOAPY_MULTI_KWARG_PREFIX).size();
+    for (const auto &pair : args)
+    {
+        if (isIndexedName(pair.first)) continue;
+        if (pair.first.find(SOAPY_MULTI_KWARG_PREFIX) != 0) continue;
+        const auto key = pair.first.substr(offset);
+        if (isMultiOption(key)) options[key] = pair.second;
+    }
+    return options;
+}
+
+/***********************************************************************
+ * Enumeration cache -- the results for each index are kept for the
+ * TTL given by multi:enum_cache_ms so that repeated discovery,
+ * such as on every reconnect attempt, does not probe the devices again.
+ **********************************************************************/
+struct SoapyMultiEnumEntry
+{
+    std::chrono::steady_clock::time_point expiry;
+    SoapySDR::KwargsList results;
+};
+
+//the cache is used from static registration, so it is created on first use
+static std::mutex &enumCacheMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<SoapySDR::Kwargs, SoapyMultiEnumEntry> &enumCache(void)
+{
+    static std::map<SoapySDR::Kwargs, SoapyMultiEnumEntry> cache;
+    return cache;
+}
+
+//! Get the unexpired results for the translated args of one index, false when there are none
+static bool lookupEnumCache(const SoapySDR::Kwargs &args, SoapySDR::KwargsList &results)
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(enumCacheMutex());
+    auto &cache = enumCache();
+    for (auto it = cache.begin(); it != cache.end();)
+    {
+        if (it->second.expiry <= now) it = cache.erase(it);
+        else ++it;
+    }
+    const auto it = cache.find(args);
+    if (it == cache.end()) return false;
+    results = it->second.results;
+    return true;
+}
+
+//! Keep the results for the translated args of one index,
+//! an index without results is not kept so that a device which appears later is found
+static void storeEnumCache(const SoapySDR::Kwargs &args, const SoapySDR::KwargsList &results, const long long ttlMs)
+{
+    if (results.empty()) return;
+    std::lock_guard<std::mutex> lock(enumCacheMutex());
+    auto &entry = enumCache()[args];
+    entry.expiry = std::chrono::steady_clock::now() + std::chrono::milliseconds(ttlMs);
+    entry.results = results;
+}
+
+/***********************************************************************
+ * Combinations of the devices found for each index
+ **********************************************************************/
+
+//! A device is the same device at every index when it has the same driver and serial, or the same args
+static std::string deviceIdentity(const SoapySDR::Kwargs &args)
+{
+    const auto serial = args.find("serial");
+    if (serial == args.end()) return SoapySDR::KwargsToString(args);
+    const auto driver = args.find("driver");
+    return ((driver == args.end())?"":driver->second) + ":" + serial->second;
+}
+
+/*!
+ * Append every combination of one result per index, from the given index on,
+ * in which no device is used at two indexes. The first results of every index
+ * come first, and the combinations are limited to SOAPY_MULTI_MAX_FIND_RESULTS:
+ * truncated is set when there are more combinations than the limit.
+ */
+static void combineResults(
+    const std::vector<SoapySDR::KwargsList> &results,
+    const size_t index,
+    SoapySDR::Kwargs &combination,
+    std::set<std::string> &used,
+    std::vector<SoapySDR::Kwargs> &combinations,
+    bool &truncated)
+{
+    if (index == results.size())
+    {
+        if (combinations.size() == SOAPY_MULTI_MAX_FIND_RESULTS) truncated = true;
+        else combinations.push_back(combination);
+        return;
+    }
+
+    for (const auto &result : results[index])
+    {
+        if (truncated) return;
+        const auto identity = deviceIdentity(result);
+        if (used.count(identity) != 0) continue;
+
+        used.insert(identity);
+        for (const auto &pair : result) combination[toIndexedName(pair.first, index)] = pair.second;
+        combineResults(results, index+1, combination, used, combinations, truncated);
+        for (const auto &pair : result) combination.erase(toIndexedName(pair.first, index));
+        used.erase(identity);
+    }
+}
+
 /***********************************************************************
  * Discovery routine -- find acceptable multi-devices
  * Because single devices instances will be discoverable normally
@@ -94,20 +226,41 @@ static std::vector<SoapySDR::Kwargs> findMultiSDR(const SoapySDR::Kwargs &args)
     const auto &argses = translateArgs(args);
     if (argses.empty()) return result;
 
-    //gather results at a specific device index
-    //TODO handle multiple results
-    SoapySDR::Kwargs result0;
+    //the indexes with cached results are not enumerated again
+    const auto options = multiOptions(args);
+    const long long ttlMs = (options.count("enum_cache_ms") != 0)?std::stoll(options.at("enum_cache_ms")):0;
+    std::vector<SoapySDR::KwargsList> results(argses.size());
+    std::vector<size_t> misses;
     for (size_t index = 0; index < argses.size(); index++)
     {
-        const auto args_i = argses.at(index);
-        const auto results_i = SoapySDR::Device::enumerate(args_i);
-        if (results_i.empty()) return result; //nothing for this index
-        for (const auto &resultArgs : results_i.front())
+        if (ttlMs <= 0 or not lookupEnumCache(argses[index], results[index])) misses.push_back(index);
+    }
+
+    //enumerate the other indexes concurrently,
+    //so the discovery takes about as long as the slowest index
+    try
+    {
+        parallelFor(misses.size(), misses.size(), [&](const size_t i)
         {
-            result0[toIndexedName(resultArgs.first, index)] = resultArgs.second;
-        }
+            const size_t index = misses[i];
+            results[index] = SoapySDR::Device::enumerate(argses[index]);
+            if (ttlMs > 0) storeEnumCache(argses[index], results[index], ttlMs);
+        });
     }
-    result.push_back(result0);
+    catch (const std::exception &ex)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "findMultiSDR() -- enumerate failed: %s", ex.what());
+        return result;
+    }
+
+    //one result per assignment of distinct devices to the indexes
+    SoapySDR::Kwargs combination;
+    std::set<std::string> used;
+    bool truncated = false;
+    combineResults(results, 0, combination, used, result, truncated);
+    if (truncated) SoapySDR::logf(SOAPY_SDR_WARNING, "findMultiSDR() -- more than %d device combinations, "
+        "only the first %d are returned, narrow the indexed args to find the others",
+        int(SOAPY_MULTI_MAX_FIND_RESULTS), int(SOAPY_MULTI_MAX_FIND_RESULTS));
 
     //remove instances of the stop key from the result
     for (auto &resultArgs : result)
@@ -142,7 +295,7 @@ static SoapySDR::Device *makeMultiSDR(const SoapySDR::Kwargs &args)
     const auto &argses = translateArgs(args);
     if (argses.empty()) throw std::runtime_error("makeMultiSDR() -- no indexed args");
 
-    return new SoapyMultiSDR(argses);
+    return new SoapyMultiSDR(argses, multiOptions(args));
 }
 
 /***********************************************************************
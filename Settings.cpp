@@ -3,41 +3,240 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SoapyMultiSDR.hpp"
+#include "MultiThreadUtils.hpp"
 #include <SoapySDR/Logger.hpp>
 #include <SoapySDR/Version.hpp>
+#include <chrono>
 #include <mutex>
 #include <stdexcept>
 
-SoapyMultiSDR::SoapyMultiSDR(const std::vector<SoapySDR::Kwargs> &args)
-{
-    _devices = SoapySDR::Device::make(args);
+SoapyMultiSDR::SoapyMultiSDR(const std::vector<SoapySDR::Kwargs> &args, const SoapySDR::Kwargs &options):
+    _makeThreads(args.size()),
+    _cacheRanges(true),
+    _cacheGetters(true),
+    _commandTimeNs(0),
+    _timedSetTimesNs(args.size(), 0),
+    _nextStreamIndex(0)
+{
+    if (options.count("make_threads") != 0) _makeThreads = std::stoul(options.at("make_threads"));
+    if (options.count("cache_ranges") != 0) _cacheRanges = options.at("cache_ranges") != "false";
+    if (options.count("cache_getters") != 0) _cacheGetters = options.at("cache_getters") != "false";
+
+    //open the devices concurrently and time each one
+    _devices.resize(args.size(), nullptr);
+    std::vector<double> makeTimesMs(args.size(), 0.0);
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    try
+    {
+        parallelFor(args.size(), _makeThreads, [&](const size_t i)
+        {
+            const auto makeTime = std::chrono::high_resolution_clock::now();
+            _devices[i] = SoapySDR::Device::make(args[i]);
+            makeTimesMs[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - makeTime).count();
+        });
+    }
+    catch (const std::exception &ex)
+    {
+        //close the devices which did open before reporting the error
+        this->unmakeDevices();
+        throw std::runtime_error("SoapyMultiSDR() -- make failed: " + std::string(ex.what()));
+    }
+
+    std::vector<std::string> makeTimes;
+    for (size_t i = 0; i < makeTimesMs.size(); i++)
+    {
+        makeTimes.push_back(std::to_string(i) + ": " + std::to_string(int(makeTimesMs[i])) + " ms");
+    }
+    SoapySDR::logf(SOAPY_SDR_INFO, "SoapyMultiSDR opened %d devices in %d ms (%s)", int(_devices.size()),
+        int(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count()),
+        csvJoin(makeTimes).c_str());
+
+    //the calling thread services device 0 for fan-out calls
+    for (size_t i = 1; i < _devices.size(); i++)
+    {
+        _fanOutWorkers.emplace_back(new SoapyMultiWorker());
+    }
 
     //load the channels lookup
     this->reloadChanMaps();
+
+    //sensor polling is off unless enabled for all devices here or per device with writeSetting()
+    for (size_t i = 0; i < _devices.size(); i++)
+    {
+        _sensorPollers.emplace_back(new SoapyMultiSensorPoller([this, i](const std::string &key)
+        {
+            return this->readPolledSensor(i, key);
+        }));
+    }
+    if (options.count("sensor_poll_ms") != 0)
+    {
+        const long intervalMs = std::stol(options.at("sensor_poll_ms"));
+        for (size_t i = 0; i < _devices.size(); i++) this->configureSensorPoll(i, intervalMs, {});
+    }
 }
 
 SoapyMultiSDR::~SoapyMultiSDR(void)
 {
-    SoapySDR::Device::unmake(_devices);
+    _sensorPollers.clear();
+    _fanOutWorkers.clear();
+    this->unmakeDevices();
+}
+
+void SoapyMultiSDR::unmakeDevices(void)
+{
+    try
+    {
+        parallelFor(_devices.size(), _makeThreads, [this](const size_t i)
+        {
+            if (_devices[i] != nullptr) SoapySDR::Device::unmake(_devices[i]);
+            _devices[i] = nullptr;
+        });
+    }
+    catch (const std::exception &ex)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "SoapyMultiSDR unmake failed: %s", ex.what());
+    }
+    _devices.clear();
+}
+
+void SoapyMultiSDR::forEachDevice(const std::function<void(const size_t)> &fcn) const
+{
+    std::lock_guard<std::mutex> lock(_fanOutMutex);
+
+    for (size_t i = 1; i < _devices.size(); i++)
+    {
+        _fanOutWorkers[i-1]->post([&fcn, i](void){fcn(i);});
+    }
+
+    std::vector<std::exception_ptr> errors(_devices.size());
+    try {fcn(0);}
+    catch (...) {errors[0] = std::current_exception();}
+
+    for (size_t i = 1; i < _devices.size(); i++)
+    {
+        try {_fanOutWorkers[i-1]->wait();}
+        catch (...) {errors[i] = std::current_exception();}
+    }
+
+    throwErrors(errors);
+}
+
+void SoapyMultiSDR::forEachDevice(const std::vector<size_t> &indexes, const std::function<void(const size_t, const size_t)> &fcn) const
+{
+    static const size_t notListed = ~size_t(0);
+    std::vector<size_t> positions(_devices.size(), notListed);
+    for (size_t pos = 0; pos < indexes.size(); pos++) positions.at(indexes[pos]) = pos;
+
+    this->forEachDevice([&](const size_t i)
+    {
+        if (positions[i] != notListed) fcn(positions[i], i);
+    });
+}
+
+void SoapyMultiSDR::clearCaches(void)
+{
+    _rangeCache.clear();
+    _rangeListCache.clear();
+    _namesCache.clear();
+    _numbersCache.clear();
+    _argInfoCache.clear();
+    _valueCache.clear();
+    _gainModeCache.clear();
+}
+
+void SoapyMultiSDR::invalidateQueries(const SoapySDR::Device *device)
+{
+    const auto predicate = [&](const SoapyMultiCacheKey &key)
+    {
+        size_t keyLocalChannel = 0;
+        return this->getDevice(std::get<0>(key), std::get<1>(key), keyLocalChannel) == device;
+    };
+    _rangeCache.erase(predicate);
+    _rangeListCache.erase(predicate);
+    _namesCache.erase(predicate);
+    _numbersCache.erase(predicate);
+    _argInfoCache.erase(predicate);
+}
+
+void SoapyMultiSDR::noteTimedSet(const size_t index, const long long timeNs)
+{
+    if (timeNs == 0) return;
+    std::lock_guard<std::mutex> lock(_timedSetMutex);
+    _timedSetTimesNs.at(index) = std::max(_timedSetTimesNs.at(index), timeNs);
+}
+
+long long SoapyMultiSDR::commandTime(void) const
+{
+    std::lock_guard<std::mutex> lock(_timedSetMutex);
+    return _commandTimeNs;
+}
+
+bool SoapyMultiSDR::timedSetPending(const size_t index) const
+{
+    long long timeNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(_timedSetMutex);
+        if (_commandTimeNs != 0) return true; //the next set call may be queued at any time
+        timeNs = _timedSetTimesNs[index];
+    }
+    if (timeNs == 0) return false;
+
+    //a device which cannot report its time never clears the pending set call
+    long long hardwareTimeNs = 0;
+    try {hardwareTimeNs = _devices[index]->getHardwareTime("");}
+    catch (const std::exception &) {return true;}
+    if (hardwareTimeNs < timeNs) return true;
+
+    std::lock_guard<std::mutex> lock(_timedSetMutex);
+    if (_timedSetTimesNs[index] == timeNs) _timedSetTimesNs[index] = 0;
+    return false;
+}
+
+void SoapyMultiSDR::invalidateValues(const int direction, const size_t channel, const std::string &query, const bool shared)
+{
+    //the set call may wait for the command time of setCommandTime()
+    const auto &chan = this->getChanMap(direction).at(channel);
+    this->noteTimedSet(chan.deviceIndex, this->commandTime());
+
+    size_t localChannel = 0;
+    const auto device = this->getDevice(direction, channel, localChannel);
+    _valueCache.erase([&](const SoapyMultiCacheKey &key)
+    {
+        if (std::get<2>(key).compare(0, query.size(), query) != 0) return false;
+        if (not shared) return std::get<0>(key) == direction and std::get<1>(key) == channel;
+        size_t keyLocalChannel = 0;
+        return this->getDevice(std::get<0>(key), std::get<1>(key), keyLocalChannel) == device;
+    });
+}
+
+void SoapyMultiSDR::invalidateValues(const SoapySDR::Device *device)
+{
+    const auto index = size_t(std::find(_devices.begin(), _devices.end(), device) - _devices.begin());
+    this->noteTimedSet(index, this->commandTime());
+
+    const auto predicate = [&](const SoapyMultiCacheKey &key)
+    {
+        size_t keyLocalChannel = 0;
+        return this->getDevice(std::get<0>(key), std::get<1>(key), keyLocalChannel) == device;
+    };
+    _valueCache.erase(predicate);
+    _gainModeCache.erase(predicate);
 }
 
 void SoapyMultiSDR::reloadChanMaps(void)
 {
-    _rxChanMap.clear();
-    _txChanMap.clear();
+    //cached queries are keyed by the global channel
+    this->clearCaches();
 
-    //map global channel index to local index with device
+    //the global channels of each device follow the channels of the previous devices
+    std::vector<size_t> numRxChannels, numTxChannels;
     for (auto device : _devices)
     {
-        for (size_t ch = 0; ch < device->getNumChannels(SOAPY_SDR_RX); ch++)
-        {
-            _rxChanMap.push_back(std::make_pair(ch, device));
-        }
-        for (size_t ch = 0; ch < device->getNumChannels(SOAPY_SDR_TX); ch++)
-        {
-            _txChanMap.push_back(std::make_pair(ch, device));
-        }
+        numRxChannels.push_back(device->getNumChannels(SOAPY_SDR_RX));
+        numTxChannels.push_back(device->getNumChannels(SOAPY_SDR_TX));
     }
+    _rxChanMap.reload(numRxChannels);
+    _txChanMap.reload(numTxChannels);
 }
 
 /*******************************************************************
@@ -103,8 +302,7 @@ std::string SoapyMultiSDR::getFrontendMapping(const int direction) const
 
 size_t SoapyMultiSDR::getNumChannels(const int direction) const
 {
-    const auto &map = (direction == SOAPY_SDR_RX)?_rxChanMap:_txChanMap;
-    return map.size();
+    return this->getChanMap(direction).size();
 }
 
 SoapySDR::Kwargs SoapyMultiSDR::getChannelInfo(const int direction, const size_t channel) const
@@ -133,16 +331,22 @@ bool SoapyMultiSDR::getFullDuplex(const int direction, const size_t channel) con
 
 std::vector<std::string> SoapyMultiSDR::listAntennas(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->listAntennas(direction, localChannel);
+    return this->cachedQuery(_namesCache, direction, channel, "listAntennas", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->listAntennas(direction, localChannel);
+    });
 }
 
 void SoapyMultiSDR::setAntenna(const int direction, const size_t channel, const std::string &name)
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setAntenna(direction, localChannel, name);
+    device->setAntenna(direction, localChannel, name);
+
+    //the gain and frequency ranges often depend on the antenna
+    this->invalidateQueries(device);
 }
 
 std::string SoapyMultiSDR::getAntenna(const int direction, const size_t channel) const
@@ -251,7 +455,8 @@ void SoapyMultiSDR::setFrequencyCorrection(const int direction, const size_t cha
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setFrequencyCorrection(direction, localChannel, value);
+    device->setFrequencyCorrection(direction, localChannel, value);
+    this->invalidateValues(direction, channel, "getFrequency", true);
 }
 
 double SoapyMultiSDR::getFrequencyCorrection(const int direction, const size_t channel) const
@@ -267,9 +472,12 @@ double SoapyMultiSDR::getFrequencyCorrection(const int direction, const size_t c
 
 std::vector<std::string> SoapyMultiSDR::listGains(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->listGains(direction, localChannel);
+    return this->cachedQuery(_namesCache, direction, channel, "listGains", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->listGains(direction, localChannel);
+    });
 }
 
 bool SoapyMultiSDR::hasGainMode(const int direction, const size_t channel) const
@@ -283,56 +491,91 @@ void SoapyMultiSDR::setGainMode(const int direction, const size_t channel, const
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setGainMode(direction, localChannel, automatic);
+    device->setGainMode(direction, localChannel, automatic);
+    _gainModeCache.erase([&](const SoapyMultiCacheKey &key)
+    {
+        return std::get<0>(key) == direction and std::get<1>(key) == channel;
+    });
+    this->invalidateValues(direction, channel, "getGain", false);
+    if (this->cachesValues(direction, channel)) this->getGainMode(direction, channel);
 }
 
 bool SoapyMultiSDR::getGainMode(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getGainMode(direction, localChannel);
+    return this->cachedValue(_gainModeCache, direction, channel, "getGainMode", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getGainMode(direction, localChannel);
+    });
 }
 
 void SoapyMultiSDR::setGain(const int direction, const size_t channel, const double value)
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setGain(direction, localChannel, value);
+    device->setGain(direction, localChannel, value);
+    this->invalidateValues(direction, channel, "getGain", false);
+
+    //the gain which the device settled on is cached right away, an automatic gain is never cached
+    if (this->cachesValues(direction, channel) and not this->getGainMode(direction, channel)) this->getGain(direction, channel);
 }
 
 void SoapyMultiSDR::setGain(const int direction, const size_t channel, const std::string &name, const double value)
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setGain(direction, localChannel, name, value);
+    device->setGain(direction, localChannel, name, value);
+    this->invalidateValues(direction, channel, "getGain", false);
+    if (this->cachesValues(direction, channel) and not this->getGainMode(direction, channel)) this->getGain(direction, channel, name);
 }
 
 double SoapyMultiSDR::getGain(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getGain(direction, localChannel);
+    const auto query = [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getGain(direction, localChannel);
+    };
+
+    //automatic gain control changes the gain at any time
+    if (not _cacheGetters or this->getGainMode(direction, channel)) return query();
+    return this->cachedValue(_valueCache, direction, channel, "getGain", query);
 }
 
 double SoapyMultiSDR::getGain(const int direction, const size_t channel, const std::string &name) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getGain(direction, localChannel, name);
+    const auto query = [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getGain(direction, localChannel, name);
+    };
+
+    //automatic gain control changes the gain at any time
+    if (not _cacheGetters or this->getGainMode(direction, channel)) return query();
+    return this->cachedValue(_valueCache, direction, channel, "getGain:" + name, query);
 }
 
 SoapySDR::Range SoapyMultiSDR::getGainRange(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getGainRange(direction, localChannel);
+    return this->cachedQuery(_rangeCache, direction, channel, "getGainRange", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getGainRange(direction, localChannel);
+    });
 }
 
 SoapySDR::Range SoapyMultiSDR::getGainRange(const int direction, const size_t channel, const std::string &name) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getGainRange(direction, localChannel, name);
+    return this->cachedQuery(_rangeCache, direction, channel, "getGainRange:" + name, [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getGainRange(direction, localChannel, name);
+    });
 }
 
 /*******************************************************************
@@ -343,56 +586,81 @@ void SoapyMultiSDR::setFrequency(const int direction, const size_t channel, cons
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setFrequency(direction, localChannel, frequency, args);
+    device->setFrequency(direction, localChannel, frequency, args);
+
+    //tuning may move LOs which are shared with other channels,
+    //the frequency which the device settled on is cached right away
+    this->invalidateValues(direction, channel, "getFrequency", true);
+    if (this->cachesValues(direction, channel)) this->getFrequency(direction, channel);
 }
 
 void SoapyMultiSDR::setFrequency(const int direction, const size_t channel, const std::string &name, const double frequency, const SoapySDR::Kwargs &args)
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setFrequency(direction, localChannel, name, frequency, args);
+    device->setFrequency(direction, localChannel, name, frequency, args);
+    this->invalidateValues(direction, channel, "getFrequency", true);
+    if (this->cachesValues(direction, channel)) this->getFrequency(direction, channel, name);
 }
 
 double SoapyMultiSDR::getFrequency(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getFrequency(direction, localChannel);
+    return this->cachedValue(_valueCache, direction, channel, "getFrequency", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getFrequency(direction, localChannel);
+    });
 }
 
 double SoapyMultiSDR::getFrequency(const int direction, const size_t channel, const std::string &name) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getFrequency(direction, localChannel, name);
+    return this->cachedValue(_valueCache, direction, channel, "getFrequency:" + name, [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getFrequency(direction, localChannel, name);
+    });
 }
 
 std::vector<std::string> SoapyMultiSDR::listFrequencies(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->listFrequencies(direction, localChannel);
+    return this->cachedQuery(_namesCache, direction, channel, "listFrequencies", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->listFrequencies(direction, localChannel);
+    });
 }
 
 SoapySDR::RangeList SoapyMultiSDR::getFrequencyRange(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getFrequencyRange(direction, localChannel);
+    return this->cachedQuery(_rangeListCache, direction, channel, "getFrequencyRange", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getFrequencyRange(direction, localChannel);
+    });
 }
 
 SoapySDR::RangeList SoapyMultiSDR::getFrequencyRange(const int direction, const size_t channel, const std::string &name) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getFrequencyRange(direction, localChannel, name);
+    return this->cachedQuery(_rangeListCache, direction, channel, "getFrequencyRange:" + name, [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getFrequencyRange(direction, localChannel, name);
+    });
 }
 
 SoapySDR::ArgInfoList SoapyMultiSDR::getFrequencyArgsInfo(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getFrequencyArgsInfo(direction, localChannel);
+    return this->cachedQuery(_argInfoCache, direction, channel, "getFrequencyArgsInfo", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getFrequencyArgsInfo(direction, localChannel);
+    });
 }
 
 /*******************************************************************
@@ -403,28 +671,43 @@ void SoapyMultiSDR::setSampleRate(const int direction, const size_t channel, con
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setSampleRate(direction, localChannel, rate);
+    device->setSampleRate(direction, localChannel, rate);
+
+    //the rate is often shared by all channels and may change the bandwidth and its ranges
+    this->invalidateQueries(device);
+    this->invalidateValues(direction, channel, "getSampleRate", true);
+    this->invalidateValues(direction, channel, "getBandwidth", true);
+    if (this->cachesValues(direction, channel)) this->getSampleRate(direction, channel);
 }
 
 double SoapyMultiSDR::getSampleRate(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getSampleRate(direction, localChannel);
+    return this->cachedValue(_valueCache, direction, channel, "getSampleRate", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getSampleRate(direction, localChannel);
+    });
 }
 
 std::vector<double> SoapyMultiSDR::listSampleRates(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->listSampleRates(direction, localChannel);
+    return this->cachedQuery(_numbersCache, direction, channel, "listSampleRates", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->listSampleRates(direction, localChannel);
+    });
 }
 
 SoapySDR::RangeList SoapyMultiSDR::getSampleRateRange(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getSampleRateRange(direction, localChannel);
+    return this->cachedQuery(_rangeListCache, direction, channel, "getSampleRateRange", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getSampleRateRange(direction, localChannel);
+    });
 }
 
 /*******************************************************************
@@ -435,28 +718,39 @@ void SoapyMultiSDR::setBandwidth(const int direction, const size_t channel, cons
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->setBandwidth(direction, localChannel, bw);
+    device->setBandwidth(direction, localChannel, bw);
+    this->invalidateValues(direction, channel, "getBandwidth", true);
+    if (this->cachesValues(direction, channel)) this->getBandwidth(direction, channel);
 }
 
 double SoapyMultiSDR::getBandwidth(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getBandwidth(direction, localChannel);
+    return this->cachedValue(_valueCache, direction, channel, "getBandwidth", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getBandwidth(direction, localChannel);
+    });
 }
 
 std::vector<double> SoapyMultiSDR::listBandwidths(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->listBandwidths(direction, localChannel);
+    return this->cachedQuery(_numbersCache, direction, channel, "listBandwidths", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->listBandwidths(direction, localChannel);
+    });
 }
 
 SoapySDR::RangeList SoapyMultiSDR::getBandwidthRange(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getBandwidthRange(direction, localChannel);
+    return this->cachedQuery(_rangeListCache, direction, channel, "getBandwidthRange", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getBandwidthRange(direction, localChannel);
+    });
 }
 
 /*******************************************************************
@@ -465,10 +759,13 @@ SoapySDR::RangeList SoapyMultiSDR::getBandwidthRange(const int direction, const
 
 void SoapyMultiSDR::setMasterClockRate(const double rate)
 {
-    for (auto device : _devices)
+    this->forEachDevice([&](const size_t i)
     {
-        device->setMasterClockRate(rate);
-    }
+        _devices[i]->setMasterClockRate(rate);
+    });
+
+    //the rates and their ranges usually depend on the master clock
+    this->clearCaches();
 }
 
 double SoapyMultiSDR::getMasterClockRate(void) const
@@ -483,10 +780,11 @@ SoapySDR::RangeList SoapyMultiSDR::getMasterClockRates(void) const
 
 void SoapyMultiSDR::setReferenceClockRate(const double rate)
 {
-    for (auto device: _devices)
+    this->forEachDevice([&](const size_t i)
     {
-        device->setReferenceClockRate(rate);
-    }
+        _devices[i]->setReferenceClockRate(rate);
+    });
+    this->clearCaches();
 }
 
 double SoapyMultiSDR::getReferenceClockRate(void) const
@@ -507,10 +805,10 @@ std::vector<std::string> SoapyMultiSDR::listClockSources(void) const
 void SoapyMultiSDR::setClockSource(const std::string &source)
 {
     const auto sources = csvSplit(source);
-    for (size_t i = 0; i < sources.size() and i < _devices.size(); i++)
+    this->forEachDevice([&](const size_t i)
     {
-        _devices[i]->setClockSource(sources.at(i));
-    }
+        if (i < sources.size()) _devices[i]->setClockSource(sources.at(i));
+    });
 }
 
 std::string SoapyMultiSDR::getClockSource(void) const
@@ -535,10 +833,10 @@ std::vector<std::string> SoapyMultiSDR::listTimeSources(void) const
 void SoapyMultiSDR::setTimeSource(const std::string &source)
 {
     const auto sources = csvSplit(source);
-    for (size_t i = 0; i < sources.size() and i < _devices.size(); i++)
+    this->forEachDevice([&](const size_t i)
     {
-        _devices[i]->setTimeSource(sources.at(i));
-    }
+        if (i < sources.size()) _devices[i]->setTimeSource(sources.at(i));
+    });
 }
 
 std::string SoapyMultiSDR::getTimeSource(void) const
@@ -563,18 +861,26 @@ long long SoapyMultiSDR::getHardwareTime(const std::string &what) const
 
 void SoapyMultiSDR::setHardwareTime(const long long timeNs, const std::string &what)
 {
-    for (auto device : _devices)
+    //release all calls together to minimize the skew between devices
+    SoapyMultiBarrier barrier(_devices.size());
+    this->forEachDevice([&](const size_t i)
     {
-        device->setHardwareTime(timeNs, what);
-    }
+        barrier.arrive();
+        _devices[i]->setHardwareTime(timeNs, what);
+    });
 }
 
 void SoapyMultiSDR::setCommandTime(const long long timeNs, const std::string &what)
 {
-    for (auto device : _devices)
+    //stop caching values before any set call can be queued
     {
-        device->setCommandTime(timeNs, what);
+        std::lock_guard<std::mutex> lock(_timedSetMutex);
+        _commandTimeNs = timeNs;
     }
+    this->forEachDevice([&](const size_t i)
+    {
+        _devices[i]->setCommandTime(timeNs, what);
+    });
 }
 
 /*******************************************************************
@@ -591,20 +897,73 @@ std::vector<std::string> SoapyMultiSDR::listSensors(void) const
             result.push_back(toIndexedName(name, i));
         }
     }
+
+    //the counters of the open streams, indexed by stream rather than device
+    std::lock_guard<std::mutex> lock(_streamsMutex);
+    for (const auto &pair : _streams)
+    {
+        result.push_back(toIndexedName(SOAPY_MULTI_STREAM_STATS, pair.first));
+    }
+
+    //the ages of the polled values of each device which is polled
+    for (size_t i = 0; i < _sensorPollers.size(); i++)
+    {
+        if (_sensorPollers[i]->intervalMs() > 0) result.push_back(toIndexedName(SOAPY_MULTI_SENSOR_AGE, i));
+    }
     return result;
 }
 
 SoapySDR::ArgInfo SoapyMultiSDR::getSensorInfo(const std::string &name) const
 {
+    if (name == SOAPY_MULTI_SENSOR_SNAPSHOT)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = name;
+        info.name = "Sensor Snapshot";
+        info.description = "JSON values of every global and per-channel sensor of each device, "
+            "read on all devices concurrently, with the time each device took to read them. "
+            "Sensors which fail to read are reported under errors.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        return info;
+    }
+
     size_t index = 0;
     const auto localName = splitIndexedName(name, index);
+    if (localName == SOAPY_MULTI_STREAM_STATS)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = name;
+        info.name = "Stream Statistics";
+        info.description = "JSON counters of each sub-stream of the stream: calls, elements, short calls, "
+            "timeouts, overflows, underflows, alignment corrections, and a histogram of call latency.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        return info;
+    }
+    if (localName == SOAPY_MULTI_SENSOR_AGE)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = name;
+        info.name = "Sensor Ages";
+        info.description = "JSON age in microseconds of the last value of each sensor polled on the device, "
+            "global sensors by name and per-channel sensors as rx<channel>:name with the channel of the device.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        return info;
+    }
     return _devices[index]->getSensorInfo(localName);
 }
 
 std::string SoapyMultiSDR::readSensor(const std::string &name) const
 {
+    if (name == SOAPY_MULTI_SENSOR_SNAPSHOT) return this->readSensorSnapshot();
+
     size_t index = 0;
     const auto localName = splitIndexedName(name, index);
+    if (localName == SOAPY_MULTI_STREAM_STATS) return this->readStreamStats(index);
+    if (localName == SOAPY_MULTI_SENSOR_AGE) return this->readSensorAges(index);
+
+    //polled sensors are served from the last values without touching the device
+    SoapyMultiSensorValue polled;
+    if (_sensorPollers.at(index)->get(localName, polled)) return polled.value;
     return _devices[index]->readSensor(localName);
 }
 
@@ -624,9 +983,122 @@ SoapySDR::ArgInfo SoapyMultiSDR::getSensorInfo(const int direction, const size_t
 
 std::string SoapyMultiSDR::readSensor(const int direction, const size_t channel, const std::string &name) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->readSensor(direction, localChannel, name);
+    const auto &chan = this->getChanMap(direction).at(channel);
+    SoapyMultiSensorValue polled;
+    if (_sensorPollers[chan.deviceIndex]->get(toChannelSensorKey(direction, chan.localChannel, name), polled)) return polled.value;
+    return _devices[chan.deviceIndex]->readSensor(direction, chan.localChannel, name);
+}
+
+void SoapyMultiSDR::configureSensorPoll(const size_t index, const long intervalMs, std::vector<std::string> sensors)
+{
+    if (sensors.empty()) sensors = _devices.at(index)->listSensors();
+    _sensorPollers.at(index)->configure(intervalMs, sensors);
+}
+
+std::string SoapyMultiSDR::readPolledSensor(const size_t index, const std::string &key) const
+{
+    int direction = SOAPY_SDR_RX;
+    size_t channel = 0;
+    std::string name;
+    if (splitChannelSensorKey(key, direction, channel, name)) return _devices[index]->readSensor(direction, channel, name);
+    return _devices[index]->readSensor(key);
+}
+
+std::string SoapyMultiSDR::readSensorAges(const size_t index) const
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::string json;
+    for (const auto &pair : *_sensorPollers.at(index)->values())
+    {
+        if (not json.empty()) json += ", ";
+        json += jsonQuote(pair.first) + ": " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(now - pair.second.time).count());
+    }
+    return "{" + json + "}";
+}
+
+/*!
+ * Read the sensors given by the list function into the members of a JSON object.
+ * A sensor which fails to read is left out and its error is added to the errors members
+ * under the sensor name and the prefix, the snapshot of the other sensors goes on.
+ */
+template <typename ListFcn, typename ReadFcn>
+static std::string sensorsToJson(const ListFcn &list, const ReadFcn &read, const std::string &prefix, std::string &errors)
+{
+    const auto addError = [&](const std::string &key, const char *what)
+    {
+        if (not errors.empty()) errors += ", ";
+        errors += jsonQuote(prefix + key) + ": " + jsonQuote(what);
+    };
+
+    std::vector<std::string> names;
+    try {names = list();}
+    catch (const std::exception &ex) {addError("", ex.what());}
+
+    std::string json;
+    for (const auto &name : names)
+    {
+        try
+        {
+            const auto value = read(name);
+            if (not json.empty()) json += ", ";
+            json += jsonQuote(name) + ": " + jsonQuote(value);
+        }
+        catch (const std::exception &ex) {addError(name, ex.what());}
+    }
+    return json;
+}
+
+std::string SoapyMultiSDR::readSensorSnapshot(void) const
+{
+    //each device reads its own sensors on its fan-out thread,
+    //so the snapshot takes as long as the slowest device rather than the sum
+    std::vector<std::string> deviceJson(_devices.size());
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    this->forEachDevice([&](const size_t i)
+    {
+        const auto device = _devices[i];
+        const auto deviceStart = std::chrono::high_resolution_clock::now();
+        std::string errors;
+        std::string json = "{\"device\": " + std::to_string(i);
+
+        json += ", \"sensors\": {" + sensorsToJson(
+            [&](void){return device->listSensors();},
+            [&](const std::string &name){return device->readSensor(name);},
+            "", errors) + "}";
+
+        //per-channel sensors are listed under the global channel numbers
+        for (const int direction : {SOAPY_SDR_RX, SOAPY_SDR_TX})
+        {
+            const auto &chanMap = this->getChanMap(direction);
+            const std::string dirName(direction == SOAPY_SDR_RX ? "rx" : "tx");
+            json += ", " + jsonQuote(dirName) + ": {";
+            for (size_t ch = 0; ch < chanMap.numChannels(i); ch++)
+            {
+                const auto channel = std::to_string(chanMap.toGlobal(i, ch));
+                if (ch != 0) json += ", ";
+                json += jsonQuote(channel) + ": {" + sensorsToJson(
+                    [&](void){return device->listSensors(direction, ch);},
+                    [&](const std::string &name){return device->readSensor(direction, ch, name);},
+                    dirName + channel + ":", errors) + "}";
+            }
+            json += "}";
+        }
+
+        const auto elapsed = std::chrono::high_resolution_clock::now() - deviceStart;
+        json += ", \"errors\": {" + errors + "}";
+        json += ", \"time_us\": " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        deviceJson[i] = json + "}";
+    });
+    const auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+    std::string json = "{\"time_us\": " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    json += ", \"devices\": [";
+    for (size_t i = 0; i < deviceJson.size(); i++)
+    {
+        if (i != 0) json += ", ";
+        json += deviceJson[i];
+    }
+    return json + "]}";
 }
 
 /*******************************************************************
@@ -646,20 +1118,33 @@ std::vector<std::string> SoapyMultiSDR::listRegisterInterfaces(void) const
     return result;
 }
 
+/*
+ * The named register calls also accept name[*] for every device and name[i,j,k]
+ * for the listed devices, which are then accessed concurrently. Reads from several
+ * devices return the values of each device in turn, in the order of the list.
+ * A broadcast is only made through such a name, the un-named calls access the first device.
+ */
+
 void SoapyMultiSDR::writeRegister(const std::string &name, const unsigned addr, const unsigned value)
 {
-    size_t index = 0;
-    const auto localName = splitIndexedName(name, index);
-    return _devices[index]->writeRegister(localName, addr, value);
+    std::vector<size_t> indexes;
+    const auto localName = splitIndexedNames(name, _devices.size(), indexes);
+    if (indexes.size() == 1) return _devices[indexes[0]]->writeRegister(localName, addr, value);
+    this->forEachDevice(indexes, [&](const size_t, const size_t i)
+    {
+        _devices[i]->writeRegister(localName, addr, value);
+    });
 }
 
 unsigned SoapyMultiSDR::readRegister(const std::string &name, const unsigned addr) const
 {
-    size_t index = 0;
-    const auto localName = splitIndexedName(name, index);
-    return _devices[index]->readRegister(localName, addr);
+    std::vector<size_t> indexes;
+    const auto localName = splitIndexedNames(name, _devices.size(), indexes);
+    if (indexes.size() != 1) throw std::runtime_error("SoapyMultiSDR::readRegister("+name+") -- use readRegisters() to read several devices");
+    return _devices[indexes[0]]->readRegister(localName, addr);
 }
 
+//the un-named registers are those of the first device, like the un-named read
 void SoapyMultiSDR::writeRegister(const unsigned addr, const unsigned value)
 {
     return _devices[0]->writeRegister(addr, value);
@@ -672,16 +1157,31 @@ unsigned SoapyMultiSDR::readRegister(const unsigned addr) const
 
 void SoapyMultiSDR::writeRegisters(const std::string &name, const unsigned addr, const std::vector<unsigned> &value)
 {
-    size_t index = 0;
-    const auto localName = splitIndexedName(name, index);
-    return _devices[index]->writeRegisters(localName, addr, value);
+    std::vector<size_t> indexes;
+    const auto localName = splitIndexedNames(name, _devices.size(), indexes);
+    if (indexes.size() == 1) return _devices[indexes[0]]->writeRegisters(localName, addr, value);
+    this->forEachDevice(indexes, [&](const size_t, const size_t i)
+    {
+        _devices[i]->writeRegisters(localName, addr, value);
+    });
 }
 
 std::vector<unsigned> SoapyMultiSDR::readRegisters(const std::string &name, const unsigned addr, const size_t length) const
 {
-    size_t index = 0;
-    const auto localName = splitIndexedName(name, index);
-    return _devices[index]->readRegisters(name, addr, length);
+    std::vector<size_t> indexes;
+    const auto localName = splitIndexedNames(name, _devices.size(), indexes);
+    if (indexes.size() == 1) return _devices[indexes[0]]->readRegisters(localName, addr, length);
+
+    //each device fills its own block so that the results line up with the list
+    std::vector<unsigned> result(length*indexes.size());
+    this->forEachDevice(indexes, [&](const size_t pos, const size_t i)
+    {
+        const auto values = _devices[i]->readRegisters(localName, addr, length);
+        if (values.size() != length) throw std::runtime_error("SoapyMultiSDR::readRegisters() -- device "
+            + std::to_string(i) + " returned " + std::to_string(values.size()) + " of " + std::to_string(length) + " values");
+        std::copy(values.begin(), values.end(), result.begin() + pos*length);
+    });
+    return result;
 }
 
 /*******************************************************************
@@ -691,6 +1191,39 @@ std::vector<unsigned> SoapyMultiSDR::readRegisters(const std::string &name, cons
 SoapySDR::ArgInfoList SoapyMultiSDR::getSettingInfo(void) const
 {
     SoapySDR::ArgInfoList result;
+
+    //settings implemented by the wrapper
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "TUNE";
+        info.name = "Batched Tune";
+        info.description = "Tune many channels at once, markup of rx<channel>=<frequency> and tx<channel>=<frequency> "
+            "with an optional time=<ns> to tune every device at that hardware time.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        result.push_back(info);
+    }
+    for (size_t i = 0; i < _devices.size(); i++)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = toIndexedName(SOAPY_MULTI_SENSOR_POLL_MS, i);
+        info.name = "Sensor Poll Interval - Device" + std::to_string(i);
+        info.description = "Read the polled sensors of the device in the background at this interval, "
+            "readSensor() then returns the last values without touching the device.";
+        info.units = "ms";
+        info.value = "0";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+
+        info.key = toIndexedName(SOAPY_MULTI_SENSOR_POLL, i);
+        info.name = "Polled Sensors - Device" + std::to_string(i);
+        info.description = "Comma separated sensors to poll, per-channel sensors as rx<channel>:name or tx<channel>:name "
+            "with the channel of the device, or empty for all global sensors of the device.";
+        info.units = "";
+        info.value = "";
+        info.type = SoapySDR::ArgInfo::STRING;
+        result.push_back(info);
+    }
+
     for (size_t i = 0; i < _devices.size(); i++)
     {
         for (auto info : _devices[i]->getSettingInfo())
@@ -717,23 +1250,60 @@ SoapySDR::ArgInfo SoapyMultiSDR::getSettingInfo(const std::string &key) const
 
 void SoapyMultiSDR::writeSetting(const std::string &key, const std::string &value)
 {
+    if (key == "TUNE")
+    {
+        std::vector<TuneRequest> requests;
+        long long timeNs = 0;
+        for (const auto &pair : SoapySDR::KwargsFromString(value))
+        {
+            if (pair.first == "time")
+            {
+                timeNs = std::stoll(pair.second);
+                continue;
+            }
+            TuneRequest request;
+            if (pair.first.compare(0, 2, "rx") == 0) request.direction = SOAPY_SDR_RX;
+            else if (pair.first.compare(0, 2, "tx") == 0) request.direction = SOAPY_SDR_TX;
+            else throw std::runtime_error("SoapyMultiSDR::writeSetting(TUNE) unknown key " + pair.first);
+            request.channel = std::stoul(pair.first.substr(2));
+            request.frequency = std::stod(pair.second);
+            requests.push_back(request);
+        }
+        return this->setFrequencies(requests, timeNs);
+    }
+
     size_t index = 0;
     const auto localKey = splitIndexedName(key, index);
-    return _devices[index]->writeSetting(localKey, value);
+    if (localKey == SOAPY_MULTI_SENSOR_POLL_MS)
+    {
+        return this->configureSensorPoll(index, std::stol(value), _sensorPollers.at(index)->sensors());
+    }
+    if (localKey == SOAPY_MULTI_SENSOR_POLL)
+    {
+        return this->configureSensorPoll(index, _sensorPollers.at(index)->intervalMs(), csvSplit(value));
+    }
+    _devices.at(index)->writeSetting(localKey, value);
+    this->invalidateQueries(_devices.at(index));
+    this->invalidateValues(_devices.at(index));
 }
 
 std::string SoapyMultiSDR::readSetting(const std::string &key) const
 {
     size_t index = 0;
     const auto localKey = splitIndexedName(key, index);
+    if (localKey == SOAPY_MULTI_SENSOR_POLL_MS) return std::to_string(_sensorPollers.at(index)->intervalMs());
+    if (localKey == SOAPY_MULTI_SENSOR_POLL) return csvJoin(_sensorPollers.at(index)->sensors());
     return _devices[index]->readSetting(localKey);
 }
 
 SoapySDR::ArgInfoList SoapyMultiSDR::getSettingInfo(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getSettingInfo(direction, localChannel);
+    return this->cachedQuery(_argInfoCache, direction, channel, "getSettingInfo", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        return device->getSettingInfo(direction, localChannel);
+    });
 }
 
 SoapySDR::ArgInfo SoapyMultiSDR::getSettingInfo(const int direction, const size_t channel, const std::string &key) const
@@ -754,7 +1324,11 @@ void SoapyMultiSDR::writeSetting(const int direction, const size_t channel, cons
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->writeSetting(direction, localChannel, key, value);
+    device->writeSetting(direction, localChannel, key, value);
+
+    //settings can have any side effect on the device
+    this->invalidateQueries(device);
+    this->invalidateValues(device);
 }
 
 std::string SoapyMultiSDR::readSetting(const int direction, const size_t channel, const std::string &key) const
@@ -876,3 +1450,48 @@ std::string SoapyMultiSDR::readUART(const std::string &which, const long timeout
     const auto localUART = splitIndexedName(which, index);
     return _devices[index]->readUART(localUART, timeoutUs);
 }
+
+/*******************************************************************
+ * Multi-device API
+ ******************************************************************/
+
+void SoapyMultiSDR::setFrequencies(const std::vector<TuneRequest> &requests, const long long timeNs)
+{
+    //group the requests by device
+    std::vector<std::vector<const TuneRequest *>> deviceRequests(_devices.size());
+    for (const auto &request : requests)
+    {
+        const auto &chan = this->getChanMap(request.direction).at(request.channel);
+        deviceRequests.at(chan.deviceIndex).push_back(&request);
+    }
+
+    this->forEachDevice([&](const size_t i)
+    {
+        if (deviceRequests[i].empty()) return;
+        auto device = _devices[i];
+        this->noteTimedSet(i, timeNs);
+        if (timeNs != 0) device->setCommandTime(timeNs, "");
+        try
+        {
+            for (const auto request : deviceRequests[i])
+            {
+                size_t localChannel = 0;
+                this->getDevice(request->direction, request->channel, localChannel);
+                device->setFrequency(request->direction, localChannel, request->frequency, request->args);
+                this->invalidateValues(request->direction, request->channel, "getFrequency", true);
+            }
+
+            //the frequencies of an untimed tune are cached right away
+            for (const auto request : deviceRequests[i])
+            {
+                if (this->cachesValues(request->direction, request->channel)) this->getFrequency(request->direction, request->channel);
+            }
+        }
+        catch (...)
+        {
+            if (timeNs != 0) device->setCommandTime(0, "");
+            throw;
+        }
+        if (timeNs != 0) device->setCommandTime(0, "");
+    });
+}
@@ -4,14 +4,41 @@
 
 #pragma once
 #include "MultiNameUtils.hpp"
+#include "MultiCacheUtils.hpp"
+#include "MultiChannelUtils.hpp"
+#include "MultiSensorUtils.hpp"
 #include <SoapySDR/Device.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <utility> //pair
 #include <vector>
 
+class SoapyMultiWorker;
+
+//! Use this key prefix to pass in args that will become local
+#define SOAPY_MULTI_KWARG_PREFIX "multi:"
+
+//! Sensor name of the stream counters, indexed by the stream
+#define SOAPY_MULTI_STREAM_STATS "stream_stats"
+
+//! Sensor name of the JSON snapshot of every sensor on every device,
+//! not indexed and not listed since reading it reads every listed sensor
+#define SOAPY_MULTI_SENSOR_SNAPSHOT "snapshot"
+
+//! Sensor name of the ages of the polled sensor values, indexed by the device
+#define SOAPY_MULTI_SENSOR_AGE "sensor_age_us"
+
+//! Setting keys of the background sensor poller, indexed by the device
+#define SOAPY_MULTI_SENSOR_POLL "SENSOR_POLL"
+#define SOAPY_MULTI_SENSOR_POLL_MS "SENSOR_POLL_MS"
+
 class SoapyMultiSDR : public SoapySDR::Device
 {
 public:
-    SoapyMultiSDR(const std::vector<SoapySDR::Kwargs> &args);
+    SoapyMultiSDR(const std::vector<SoapySDR::Kwargs> &args, const SoapySDR::Kwargs &options);
     ~SoapyMultiSDR(void);
 
     /*******************************************************************
@@ -373,22 +400,143 @@ public:
 
     std::string readUART(const std::string &which, const long timeoutUs) const;
 
+    /*******************************************************************
+     * Multi-device API
+     ******************************************************************/
+
+    //! A frequency change for one channel in a batched tune
+    struct TuneRequest
+    {
+        int direction;
+        size_t channel;
+        double frequency;
+        SoapySDR::Kwargs args;
+    };
+
+    /*!
+     * Tune many channels with one call.
+     * The requests are grouped by device and the devices are tuned concurrently.
+     * When timeNs is non-zero, each device tunes at that hardware time:
+     * the command time is set before the device's requests and cleared after,
+     * and the getters of the device are not cached until its hardware time reaches timeNs.
+     * Also available as the TUNE setting with markup such as "rx0=1e9, tx1=2e9, time=1000000".
+     */
+    void setFrequencies(const std::vector<TuneRequest> &requests, const long long timeNs = 0);
+
 private:
 
+    //! Get the channel map of the direction
+    const SoapyMultiChannelMap &getChanMap(const int direction) const
+    {
+        return (direction == SOAPY_SDR_RX)?_rxChanMap:_txChanMap;
+    }
+
     //! Get the internal device pointer given the channel and direction
     SoapySDR::Device *getDevice(const int direction, const size_t channel, size_t &localChannel) const
     {
-        const auto &map = (direction == SOAPY_SDR_RX)?_rxChanMap:_txChanMap;
-        const auto &pair = map.at(channel);
-        localChannel = pair.first;
-        return pair.second;
+        const auto &chan = this->getChanMap(direction).at(channel);
+        localChannel = chan.localChannel;
+        return _devices[chan.deviceIndex];
     }
 
     //internal devices mapped by device index
     std::vector<SoapySDR::Device *> _devices;
 
-    //mapping of channel index to internal device pointer
+    //concurrent open and close of the internal devices
+    void unmakeDevices(void);
+    size_t _makeThreads;
+
+    //! Call the function with every device index concurrently, errors are gathered and thrown
+    void forEachDevice(const std::function<void(const size_t)> &fcn) const;
+
+    //! Call the function with the position in the list and index of each listed device concurrently
+    void forEachDevice(const std::vector<size_t> &indexes, const std::function<void(const size_t, const size_t)> &fcn) const;
+    mutable std::mutex _fanOutMutex;
+    std::vector<std::unique_ptr<SoapyMultiWorker>> _fanOutWorkers;
+
+    //! Serve the per-channel query from the cache unless caching is disabled
+    template <typename Type, typename QueryFcn>
+    Type cachedQuery(SoapyMultiCache<Type> &cache, const int direction, const size_t channel, const std::string &name, const QueryFcn &query) const
+    {
+        if (not _cacheRanges) return query();
+        return cache.get(SoapyMultiCacheKey(direction, channel, name), query);
+    }
+
+    //caches for per-channel ranges and lists
+    void clearCaches(void);
+
+    //! Forget the cached ranges and lists of every channel on the device
+    void invalidateQueries(const SoapySDR::Device *device);
+    bool _cacheRanges;
+    mutable SoapyMultiCache<SoapySDR::Range> _rangeCache;
+    mutable SoapyMultiCache<SoapySDR::RangeList> _rangeListCache;
+    mutable SoapyMultiCache<std::vector<std::string>> _namesCache;
+    mutable SoapyMultiCache<std::vector<double>> _numbersCache;
+    mutable SoapyMultiCache<SoapySDR::ArgInfoList> _argInfoCache;
+
+    //! Serve the per-channel getter from the cache unless caching is disabled
+    //! or a set call on the device may still wait for its command time
+    template <typename Type, typename QueryFcn>
+    Type cachedValue(SoapyMultiCache<Type> &cache, const int direction, const size_t channel, const std::string &name, const QueryFcn &query) const
+    {
+        if (not this->cachesValues(direction, channel)) return query();
+        return cache.get(SoapyMultiCacheKey(direction, channel, name), query);
+    }
+
+    //! True when the getters of the channel are served from the cache
+    bool cachesValues(const int direction, const size_t channel) const
+    {
+        return _cacheGetters and not this->timedSetPending(this->getChanMap(direction).at(channel).deviceIndex);
+    }
+
+    //! Note a set call on the device which takes effect at the command time, nothing when the time is 0
+    void noteTimedSet(const size_t index, const long long timeNs);
+
+    //! True until the hardware time of the device reaches the command time of its last timed set call,
+    //! and always while a command time is set
+    bool timedSetPending(const size_t index) const;
+
+    //! The time of setCommandTime(), 0 when cleared
+    long long commandTime(void) const;
+
+    //! Forget cached values for the query after a set call on the channel,
+    //! when shared is true the values of every channel on the same device are forgotten
+    void invalidateValues(const int direction, const size_t channel, const std::string &query, const bool shared);
+
+    //! Forget all cached values of the device
+    void invalidateValues(const SoapySDR::Device *device);
+
+    //cache for values read back from the devices
+    bool _cacheGetters;
+    mutable std::mutex _timedSetMutex;
+    long long _commandTimeNs; //the time of setCommandTime(), 0 when cleared
+    mutable std::vector<long long> _timedSetTimesNs; //by device index, 0 when no set call is pending
+    mutable SoapyMultiCache<double> _valueCache;
+    mutable SoapyMultiCache<bool> _gainModeCache;
+
+    //! Read every global and per-channel sensor of all devices concurrently into JSON
+    std::string readSensorSnapshot(void) const;
+
+    //! Poll the sensors of the device in the background, all global sensors when none are given
+    void configureSensorPoll(const size_t index, const long intervalMs, std::vector<std::string> sensors);
+
+    //! Read the sensor of the device given by its poller key
+    std::string readPolledSensor(const size_t index, const std::string &key) const;
+
+    //! The ages of the polled sensor values of the device as JSON
+    std::string readSensorAges(const size_t index) const;
+
+    //background sensor pollers by device index, readSensor() serves their values
+    std::vector<std::unique_ptr<SoapyMultiSensorPoller>> _sensorPollers;
+
+    //open streams by stream index for the stream_stats sensors
+    std::string readStreamStats(const size_t index) const;
+    mutable std::mutex _streamsMutex;
+    std::map<size_t, SoapySDR::Stream *> _streams;
+    size_t _nextStreamIndex;
+
+    //mapping of global channel index to device index and local channel
     void reloadChanMaps(void);
-    std::vector<std::pair<size_t, SoapySDR::Device *>> _rxChanMap;
-    std::vector<std::pair<size_t, SoapySDR::Device *>> _txChanMap;
+    SoapyMultiChannelMap _rxChanMap;
+    SoapyMultiChannelMap _txChanMap;
 };
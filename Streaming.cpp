@@ -2,28 +2,1094 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SoapyMultiSDR.hpp"
+#include "MultiThreadUtils.hpp"
+#include "MultiRingUtils.hpp"
+#include "MultiFormatUtils.hpp"
+#include "MultiStatsUtils.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Time.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+//! A run of ring elements which starts on a known timestamp
+struct SoapyMultiSegment
+{
+    unsigned long long index; //ring index of the first element
+    long long timeNs;
+    int flags;
+    int error; //reported to the consumer before the elements
+};
+
+//! Background acquisition of one sub-stream into a ring
+struct SoapyMultiReader
+{
+    SoapyMultiReader(const size_t numChannels, const size_t elemSize, const size_t capacity);
+
+    SoapyMultiRing ring;
+    SoapyMultiQueue<SoapyMultiSegment> segments;
+    SoapyMultiSegment current; //owned by the consumer
+    std::atomic<bool> running;
+    std::thread thread;
+
+    //wakes the consumer when elements are committed
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+//! A status event of a sub-stream with the channel mask in stream channels
+struct SoapyMultiStatus
+{
+    int ret;
+    size_t chanMask;
+    int flags;
+    long long timeNs;
+};
+
+//! Background polling of the status of every sub-stream into one queue
+struct SoapyMultiStatusCollector
+{
+    std::atomic<bool> running;
+    std::vector<std::thread> threads;
+
+    //events in order of arrival from every poller thread
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<SoapyMultiStatus> events;
+    size_t numPolling; //sub-streams which support status
+};
+
+//! What readStream does when the timestamps of the sub-streams differ
+enum SoapyMultiSkewPolicy
+{
+    SOAPY_MULTI_SKEW_DROP, //drop the leading elements of the early sub-streams
+    SOAPY_MULTI_SKEW_PAD, //pad the late sub-streams with leading zeros
+    SOAPY_MULTI_SKEW_WARN, //log a warning over the threshold
+    SOAPY_MULTI_SKEW_ERROR, //fail the read over the threshold, the next read is aligned by dropping
+    SOAPY_MULTI_SKEW_IGNORE, //only measure the skew
+};
+
+//! The per-device handles behind one direct access handle of the wrapper
+struct SoapyMultiHandle
+{
+    bool acquired;
+    std::vector<size_t> handles; //indexed by sub-stream
+
+    //a read acquire which failed on a later sub-stream keeps the buffers of the earlier
+    //sub-streams, and the next acquire resumes there so that no channel loses samples
+    size_t numPending; //sub-streams acquired so far
+    int pendingRet;
+    int pendingFlags;
+    long long pendingTimeNs;
+    std::vector<const void *> pendingBuffs; //indexed by stream channel
+};
 
 struct SoapyMultiStreamData
 {
     SoapySDR::Device *device;
+    size_t deviceIndex;
     SoapySDR::Stream *stream;
     std::vector<size_t> channels;
+    size_t elemSize;
+
+    //position of each channel in the stream channel list, reordered channels are
+    //gathered into the routes, otherwise the caller's buffer array is used in place
+    std::vector<size_t> buffIndexes;
+    bool contiguous;
+    std::vector<void *> route;
+    std::vector<const void *> constRoute;
+    double rate; //used to convert timestamps into elements
+    size_t mtu; //of the sub-stream in elements
+    bool coalesce; //feed the sub-stream whole MTUs
+
+    //staging for reads under the MTU, the surplus joins the remainder
+    std::vector<std::vector<char>> stageBuffs;
+    std::vector<void *> stagePtrs;
+
+    //optional worker thread for parallel stream calls
+    std::unique_ptr<SoapyMultiWorker> worker;
+
+    //per-call arguments and results for the sub-stream
+    void * const *buffs;
+    const void * const *writeBuffs;
+    size_t numElems;
+    int flags;
+    long long timeNs;
+    long timeoutUs;
+    int ret;
+
+    //surplus elements carried over between read calls
+    std::vector<std::vector<char>> remainder;
+    size_t numRemainder;
+    size_t numFromRemainder; //copied out on the current call
+    size_t numDrop; //leading elements dropped for alignment
+    long long remainderTimeNs;
+    int remainderFlags;
+    std::vector<void *> readBuffs;
+
+    //elements committed by the device past the last write result
+    size_t numAhead;
+    std::vector<const void *> aheadBuffs;
+
+    //optional background reader which decouples the device from readStream
+    std::unique_ptr<SoapyMultiReader> reader;
+
+    //optional conversion between the stream format and the native format of the sub-stream,
+    //the sub-stream reads from and writes to the conversion buffers in its native format
+    SoapyMultiConverter converter;
+    std::vector<std::vector<char>> convertBuffs;
+    std::vector<void *> convertPtrs;
+    void * const *userBuffs; //caller's buffers of a converted read
+
+    //counters of the calls on the sub-stream
+    std::unique_ptr<SoapyMultiStats> stats;
 };
 
 struct SoapyMultiStreamsData : std::vector<SoapyMultiStreamData>
 {
-    //placeholder for book-keeping common to all streams
+    //book-keeping common to all streams
+    size_t index; //of the stream_stats sensor
+    int direction;
+    SoapyMultiSkewPolicy skewPolicy;
+    long long skewThresholdNs;
+    std::chrono::high_resolution_clock::time_point skewWarnTime;
+    long long alignWindowNs;
+    bool alignWarned;
+    long long bufferNs; //depth of the background read rings, 0 when disabled
+    bool convert; //at least one sub-stream converts the format
+    size_t mtu; //aggregate of the sub-stream MTUs
+    long long startMarginNs; //coordinated activation ahead of the hardware time, 0 when disabled
+    long long stopMarginNs; //coordinated deactivation ahead of the hardware time, 0 when disabled
+
+    //optional interleaved output, the sub-streams read into per-channel buffers first
+    bool interleaved;
+    size_t elemSize; //of the stream format
+    std::vector<std::vector<char>> layoutBuffs;
+    std::vector<void *> layoutPtrs;
+
+    //status events of all sub-streams, polled from the first readStreamStatus until deactivation,
+    //and again from each activation after that
+    std::mutex statusMutex; //serializes starting and stopping the pollers
+    std::unique_ptr<SoapyMultiStatusCollector> status;
+
+    //optional periodic log of the counters
+    long long statsLogNs;
+    std::chrono::high_resolution_clock::time_point statsLogTime;
+
+    //direct access handles, limited by the sub-stream with the fewest buffers
+    std::vector<SoapyMultiHandle> handles;
 };
 
+//! Limit on saved surplus as a multiple of the requested elements
+static const size_t SOAPY_MULTI_MAX_REMAINDER_READS = 16;
+
+//! Limit on pending timestamp discontinuities in a background read ring
+static const size_t SOAPY_MULTI_MAX_SEGMENTS = 1024;
+
+//! Timeout of the background reads, bounds the time to stop a reader
+static const long SOAPY_MULTI_READER_TIMEOUT_US = 100000;
+
+//! Limit on queued status events, the oldest events are dropped
+static const size_t SOAPY_MULTI_MAX_STATUS_EVENTS = 1024;
+
+//! Limit on the LCM-aligned MTU in elements, larger multiples fall back to the largest MTU
+static const size_t SOAPY_MULTI_MAX_LCM_MTU = 1 << 20;
+
+SoapyMultiReader::SoapyMultiReader(const size_t numChannels, const size_t elemSize, const size_t capacity):
+    ring(numChannels, elemSize, capacity),
+    segments(SOAPY_MULTI_MAX_SEGMENTS),
+    running(false)
+{
+    return;
+}
+
+/*******************************************************************
+ * Stream args helpers
+ ******************************************************************/
+
+//! Split off the args with the multi prefix which configure the wrapper
+static SoapySDR::Kwargs splitMultiArgs(const SoapySDR::Kwargs &args, SoapySDR::Kwargs &subArgs)
+{
+    SoapySDR::Kwargs multiArgs;
+    static const size_t offset = std::string(SOAPY_MULTI_KWARG_PREFIX).size();
+    for (const auto &pair : args)
+    {
+        if (pair.first.find(SOAPY_MULTI_KWARG_PREFIX) == 0)
+        {
+            multiArgs[pair.first.substr(offset)] = pair.second;
+        }
+        else subArgs[pair.first] = pair.second;
+    }
+    return multiArgs;
+}
+
+/*******************************************************************
+ * MTU helpers
+ ******************************************************************/
+
+static size_t gcdMTU(const size_t a, const size_t b)
+{
+    return (b == 0)?a:gcdMTU(b, a % b);
+}
+
+/*!
+ * The MTU reported for the stream: the smallest sub-stream MTU,
+ * or with lcm the smallest size which is a whole number of MTUs on every sub-stream.
+ */
+static size_t aggregateMTU(const SoapyMultiStreamsData &multiStreams, const bool lcm)
+{
+    size_t minMTU = multiStreams.front().mtu, maxMTU = minMTU, lcmMTU = 1;
+    for (const auto &data : multiStreams)
+    {
+        minMTU = std::min(minMTU, data.mtu);
+        maxMTU = std::max(maxMTU, data.mtu);
+        if (lcmMTU <= SOAPY_MULTI_MAX_LCM_MTU) lcmMTU = lcmMTU/gcdMTU(lcmMTU, data.mtu)*data.mtu;
+    }
+    if (not lcm) return minMTU;
+    if (lcmMTU <= SOAPY_MULTI_MAX_LCM_MTU) return lcmMTU;
+
+    SoapySDR::logf(SOAPY_SDR_WARNING, "SoapyMultiSDR::setupStream() -- "
+        "the sub-stream MTUs have no common multiple under %d elements, using the largest MTU", int(SOAPY_MULTI_MAX_LCM_MTU));
+    return maxMTU;
+}
+
+//! The time left until the shared deadline of the sub-stream calls, 0 once it passed
+static long timeLeftUs(const std::chrono::high_resolution_clock::time_point &exitTime)
+{
+    const auto timeLeft = std::chrono::duration_cast<std::chrono::microseconds>(
+        exitTime - std::chrono::high_resolution_clock::now()).count();
+    return long(std::max<long long>(timeLeft, 0));
+}
+
+/*******************************************************************
+ * Background reader
+ ******************************************************************/
+
+/*!
+ * The reader thread reads the sub-stream directly into the ring.
+ * A segment is queued whenever the timestamps stop being contiguous,
+ * and the overflow or error which caused the break is reported
+ * to the consumer when it reaches the start of the segment.
+ * When the ring is full, the elements are read and dropped
+ * so that the device itself does not overflow.
+ * An error is retried at once, and a device which keeps failing
+ * is retried with a growing wait of up to the read timeout.
+ */
+static void runReader(SoapyMultiStreamData &data)
+{
+    auto &reader = *data.reader;
+    const size_t mtu = std::max<size_t>(data.device->getStreamMTU(data.stream), 1);
+    const long long toleranceNs = (data.rate > 0.0)?SoapySDR::ticksToTimeNs(1, data.rate)/2:0;
+    std::vector<void *> buffs(data.channels.size());
+    std::vector<std::vector<char>> dropped;
+
+    int pendingError = 0;
+    long backoffUs = 0; //the wait after the next error
+    bool contiguous = false;
+    int lastFlags = 0;
+    long long nextTimeNs = 0;
+    while (reader.running)
+    {
+        size_t numFree = reader.ring.writeBuffs(buffs.data());
+        const bool full = (numFree == 0);
+        if (full)
+        {
+            dropped.resize(data.channels.size(), std::vector<char>(mtu*data.elemSize));
+            for (size_t ch = 0; ch < buffs.size(); ch++) buffs[ch] = dropped[ch].data();
+            numFree = mtu;
+        }
+
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = data.device->readStream(data.stream, buffs.data(), numFree, flags, timeNs, SOAPY_MULTI_READER_TIMEOUT_US);
+        if (ret == SOAPY_SDR_TIMEOUT or ret == 0) continue;
+        if (ret < 0)
+        {
+            const SoapyMultiSegment segment = {reader.ring.writeIndex(), 0, 0, ret};
+            pendingError = reader.segments.push(segment)?0:ret;
+            contiguous = false;
+            if (backoffUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(backoffUs));
+            backoffUs = std::min(std::max(2*backoffUs, 1000L), SOAPY_MULTI_READER_TIMEOUT_US);
+            continue;
+        }
+        backoffUs = 0;
+        if (full)
+        {
+            pendingError = SOAPY_SDR_OVERFLOW;
+            contiguous = false;
+            continue;
+        }
+
+        const bool hasTime = (flags & SOAPY_SDR_HAS_TIME) != 0;
+        if (hasTime != ((lastFlags & SOAPY_SDR_HAS_TIME) != 0)) contiguous = false;
+        if (hasTime and std::abs(timeNs - nextTimeNs) > toleranceNs) contiguous = false;
+        if (not contiguous)
+        {
+            const SoapyMultiSegment segment = {reader.ring.writeIndex(), timeNs, flags & SOAPY_SDR_HAS_TIME, pendingError};
+            if (not reader.segments.push(segment))
+            {
+                pendingError = SOAPY_SDR_OVERFLOW;
+                continue;
+            }
+            pendingError = 0;
+        }
+
+        //without a rate the timestamps of later elements are unknown
+        contiguous = data.rate > 0.0;
+        lastFlags = flags;
+        if (contiguous) nextTimeNs = timeNs + SoapySDR::ticksToTimeNs(ret, data.rate);
+
+        reader.ring.commit(size_t(ret));
+        {
+            std::lock_guard<std::mutex> lock(reader.mutex);
+        }
+        reader.cond.notify_one();
+    }
+}
+
+//! Read from the ring of the background reader, has the same results as readStream()
+static int readRing(SoapyMultiStreamData &data, void * const *buffs, const size_t numElems, int &flags, long long &timeNs, const long timeoutUs)
+{
+    auto &reader = *data.reader;
+    const auto ready = [&reader](void)
+    {
+        return reader.ring.readable() != 0 or not reader.segments.empty();
+    };
+    if (not ready())
+    {
+        std::unique_lock<std::mutex> lock(reader.mutex);
+        if (not reader.cond.wait_for(lock, std::chrono::microseconds(timeoutUs), ready)) return SOAPY_SDR_TIMEOUT;
+    }
+
+    //enter the segments which start at the read index
+    const auto readIndex = reader.ring.readIndex();
+    while (not reader.segments.empty() and reader.segments.front().index <= readIndex)
+    {
+        reader.current = reader.segments.front();
+        reader.segments.pop();
+        if (reader.current.error == 0) continue;
+        const int error = reader.current.error;
+        reader.current.error = 0;
+        return error;
+    }
+
+    //a read never crosses into the next segment
+    size_t numRead = std::min(numElems, reader.ring.readable());
+    if (not reader.segments.empty()) numRead = std::min(numRead, size_t(reader.segments.front().index - readIndex));
+    reader.ring.read(buffs, numRead);
+
+    flags = reader.current.flags;
+    timeNs = reader.current.timeNs;
+    if (data.rate > 0.0) timeNs += SoapySDR::ticksToTimeNs(readIndex - reader.current.index, data.rate);
+    return int(numRead);
+}
+
+//! Start the background reader with a ring of the configured depth
+static void startReader(SoapyMultiStreamData &data, const long long bufferNs)
+{
+    const size_t mtu = std::max<size_t>(data.device->getStreamMTU(data.stream), 1);
+    size_t capacity = 4*mtu;
+    if (data.rate > 0.0) capacity = std::max(capacity, size_t(SoapySDR::timeNsToTicks(bufferNs, data.rate)));
+    if (not data.reader or data.reader->ring.capacity() != capacity)
+    {
+        data.reader.reset(new SoapyMultiReader(data.channels.size(), data.elemSize, capacity));
+    }
+
+    auto &reader = *data.reader;
+    reader.ring.reset();
+    reader.segments.clear();
+    reader.current = SoapyMultiSegment();
+    reader.running = true;
+    reader.thread = std::thread(&runReader, std::ref(data));
+}
+
+//! Stop the background reader, the ring is kept for the next activation
+static void stopReader(SoapyMultiStreamData &data)
+{
+    if (not data.reader or not data.reader->thread.joinable()) return;
+    data.reader->running = false;
+    data.reader->thread.join();
+}
+
+/*******************************************************************
+ * Channel routing helpers
+ ******************************************************************/
+
+//! The caller's buffers of the sub-stream channels, reordered channels are gathered into the route
+template <typename Ptr>
+static Ptr const *gatherBuffs(const SoapyMultiStreamData &data, Ptr const *buffs, std::vector<Ptr> &route)
+{
+    if (data.contiguous) return buffs + data.buffIndexes.front();
+    for (size_t ch = 0; ch < route.size(); ch++) route[ch] = buffs[data.buffIndexes[ch]];
+    return route.data();
+}
+
+//! Where the sub-stream outputs the addresses of its buffers, see scatterBuffs()
+template <typename Ptr>
+static Ptr *routeBuffs(const SoapyMultiStreamData &data, Ptr *buffs, std::vector<Ptr> &route)
+{
+    return data.contiguous?(buffs + data.buffIndexes.front()):route.data();
+}
+
+//! Move the buffer addresses output through the route into the caller's buffer array
+template <typename Ptr>
+static void scatterBuffs(const SoapyMultiStreamData &data, Ptr *buffs, const std::vector<Ptr> &route)
+{
+    if (data.contiguous) return;
+    for (size_t ch = 0; ch < route.size(); ch++) buffs[data.buffIndexes[ch]] = route[ch];
+}
+
+/*******************************************************************
+ * Status collector
+ ******************************************************************/
+
+/*!
+ * Poll the status of one sub-stream until the collector stops or the device does not support status.
+ * An error is queued like any other event, and a device which keeps failing
+ * is polled with a growing wait of up to the poll timeout.
+ */
+static void runStatusPoller(SoapyMultiStreamsData &multiStreams, const size_t index)
+{
+    auto &data = multiStreams[index];
+    auto &status = *multiStreams.status;
+    long backoffUs = 0; //the wait after the next error
+    while (status.running)
+    {
+        SoapyMultiStatus event = {0, 0, 0, 0};
+        event.ret = data.device->readStreamStatus(data.stream, event.chanMask, event.flags, event.timeNs, SOAPY_MULTI_READER_TIMEOUT_US);
+        if (event.ret == SOAPY_SDR_TIMEOUT) continue;
+
+        std::unique_lock<std::mutex> lock(status.mutex);
+        if (event.ret == SOAPY_SDR_NOT_SUPPORTED) status.numPolling--;
+        else
+        {
+            //from sub-stream channels to stream channels
+            size_t chanMask = 0;
+            for (size_t ch = 0; ch < data.buffIndexes.size(); ch++)
+            {
+                if (((event.chanMask >> ch) & 1) != 0) chanMask |= size_t(1) << data.buffIndexes[ch];
+            }
+            event.chanMask = chanMask;
+            if (status.events.size() == SOAPY_MULTI_MAX_STATUS_EVENTS) status.events.pop_front();
+            status.events.push_back(event);
+        }
+        status.cond.notify_one();
+        if (event.ret == SOAPY_SDR_NOT_SUPPORTED) return;
+        lock.unlock();
+
+        if (event.ret >= 0) backoffUs = 0;
+        else
+        {
+            if (backoffUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(backoffUs));
+            backoffUs = std::min(std::max(2*backoffUs, 1000L), SOAPY_MULTI_READER_TIMEOUT_US);
+        }
+    }
+}
+
+//! Start a status poller thread for every sub-stream unless they are running, call with the status mutex held
+static void startStatus(SoapyMultiStreamsData &multiStreams)
+{
+    if (not multiStreams.status) multiStreams.status.reset(new SoapyMultiStatusCollector());
+    auto &status = *multiStreams.status;
+    if (not status.threads.empty()) return;
+    status.running = true;
+    {
+        std::lock_guard<std::mutex> lock(status.mutex);
+        status.numPolling = multiStreams.size();
+    }
+
+    for (size_t i = 0; i < multiStreams.size(); i++)
+    {
+        status.threads.emplace_back(&runStatusPoller, std::ref(multiStreams), i);
+    }
+}
+
+//! Stop the status poller threads, the queued events are kept, call with the status mutex held
+static void stopStatus(SoapyMultiStreamsData &multiStreams)
+{
+    if (not multiStreams.status) return;
+    multiStreams.status->running = false;
+    for (auto &thread : multiStreams.status->threads) thread.join();
+    multiStreams.status->threads.clear();
+}
+
+/*******************************************************************
+ * Sub-stream read helpers
+ ******************************************************************/
+
+//! Size the conversion buffers for numElems native elements, \return the buffer pointers
+static void * const *getConvertBuffs(SoapyMultiStreamData &data, const size_t numElems)
+{
+    for (size_t ch = 0; ch < data.channels.size(); ch++)
+    {
+        auto &buff = data.convertBuffs[ch];
+        buff.resize(std::max(buff.size(), numElems*data.elemSize));
+        data.convertPtrs[ch] = buff.data();
+    }
+    return data.convertPtrs.data();
+}
+
+/*!
+ * Copy the first numNeeded elements of a staged read into the read buffers.
+ * The surplus is appended to the remainder, which was fully copied out
+ * before the read, so it follows the elements that the next call saves.
+ * \return the number of elements copied into the read buffers
+ */
+static size_t unstageRead(SoapyMultiStreamData &data, const size_t numRead, const size_t numNeeded)
+{
+    const size_t numCopy = std::min(numRead, numNeeded);
+    const size_t numSurplus = numRead - numCopy;
+    for (size_t ch = 0; ch < data.channels.size(); ch++)
+    {
+        const auto stage = data.stageBuffs[ch].data();
+        std::memcpy(data.readBuffs[ch], stage, numCopy*data.elemSize);
+
+        auto &remainder = data.remainder[ch];
+        remainder.resize(std::max(remainder.size(), (data.numRemainder+numSurplus)*data.elemSize));
+        std::memcpy(remainder.data() + data.numRemainder*data.elemSize, stage + numCopy*data.elemSize, numSurplus*data.elemSize);
+    }
+    data.numRemainder += numSurplus;
+    return numCopy;
+}
+
+//! Perform the read on a single sub-stream given the stored arguments
+static void readSubStream(SoapyMultiStreamData &data)
+{
+    //a converted read is merged in the native format and converted at the end
+    if (not data.converter.empty())
+    {
+        data.userBuffs = data.buffs;
+        data.buffs = getConvertBuffs(data, data.numElems);
+    }
+
+    //the remainder from previous calls leads the buffer
+    data.numFromRemainder = std::min(data.numRemainder, data.numElems);
+    for (size_t ch = 0; ch < data.channels.size() and data.numFromRemainder != 0; ch++)
+    {
+        std::memcpy(data.buffs[ch], data.remainder[ch].data(), data.numFromRemainder*data.elemSize);
+    }
+    if (data.numFromRemainder == data.numElems)
+    {
+        data.flags = data.remainderFlags;
+        data.timeNs = data.remainderTimeNs;
+        data.ret = int(data.numFromRemainder);
+        return;
+    }
+
+    //read the rest of the buffer from the device,
+    //a request under the MTU reads a whole MTU into the staging buffers
+    const size_t numNeeded = data.numElems-data.numFromRemainder;
+    const bool stage = data.coalesce and not data.reader and numNeeded < data.mtu;
+    for (size_t ch = 0; ch < data.channels.size(); ch++)
+    {
+        data.readBuffs[ch] = static_cast<char *>(data.buffs[ch]) + data.numFromRemainder*data.elemSize;
+    }
+    void * const *readBuffs = stage?data.stagePtrs.data():data.readBuffs.data();
+    const size_t numRead = stage?data.mtu:numNeeded;
+
+    int flags = data.flags;
+    long long timeNs = 0;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    int ret = data.reader?
+        readRing(data, readBuffs, numRead, flags, timeNs, data.timeoutUs):
+        data.device->readStream(data.stream, readBuffs, numRead, flags, timeNs, data.timeoutUs);
+    data.stats->record(ret, numRead, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count());
+    if (stage and ret > 0) ret = int(unstageRead(data, size_t(ret), numNeeded));
+
+    if (data.numFromRemainder == 0)
+    {
+        data.flags = flags;
+        data.timeNs = timeNs;
+        data.ret = ret;
+        return;
+    }
+
+    //a timeout only means that there is nothing past the remainder yet,
+    //any other error breaks the continuity so the remainder is stale
+    data.flags = data.remainderFlags;
+    data.timeNs = data.remainderTimeNs;
+    if (ret >= 0) data.ret = int(data.numFromRemainder) + ret;
+    else if (ret == SOAPY_SDR_TIMEOUT) data.ret = int(data.numFromRemainder);
+    else
+    {
+        data.ret = ret;
+        data.numRemainder = 0;
+        data.numFromRemainder = 0;
+        data.numAhead = 0;
+    }
+}
+
+//! Save the elements of the last read past numConsumed for the next call
+static void consumeSubStream(SoapyMultiStreamData &data, size_t numConsumed)
+{
+    const size_t numRead = (data.ret > 0)?size_t(data.ret):0;
+    const size_t numTail = data.numRemainder - data.numFromRemainder;
+    const size_t maxRemainder = std::max(data.numElems, data.mtu)*SOAPY_MULTI_MAX_REMAINDER_READS;
+
+    //drop the oldest elements when the other sub-streams stopped consuming
+    if (numRead - numConsumed + numTail > maxRemainder)
+    {
+        numConsumed = std::min(numRead, numRead + numTail - maxRemainder);
+    }
+    const size_t numSave = numRead - numConsumed;
+
+    //the tail of the remainder which was never copied out stays behind the saved elements
+    for (size_t ch = 0; ch < data.channels.size() and numSave != 0; ch++)
+    {
+        auto &remainder = data.remainder[ch];
+        remainder.resize(std::max(remainder.size(), (numSave+numTail)*data.elemSize));
+        std::memmove(remainder.data() + numSave*data.elemSize,
+            remainder.data() + data.numFromRemainder*data.elemSize, numTail*data.elemSize);
+        std::memcpy(remainder.data(),
+            static_cast<const char *>(data.buffs[ch]) + numConsumed*data.elemSize, numSave*data.elemSize);
+    }
+    if (numSave == 0 and numTail != 0) for (auto &remainder : data.remainder)
+    {
+        std::memmove(remainder.data(),
+            remainder.data() + data.numFromRemainder*data.elemSize, numTail*data.elemSize);
+    }
+
+    if (numRead != 0)
+    {
+        data.remainderFlags = data.flags & SOAPY_SDR_HAS_TIME;
+        data.remainderTimeNs = data.timeNs;
+        if (data.rate > 0.0) data.remainderTimeNs += SoapySDR::ticksToTimeNs(numConsumed, data.rate);
+    }
+    data.numRemainder = numSave + numTail;
+    data.numFromRemainder = 0;
+}
+
+//! Forget all saved surplus elements, used when the stream restarts
+static void clearSubStreams(SoapyMultiStreamsData &multiStreams)
+{
+    for (auto &data : multiStreams)
+    {
+        data.numRemainder = 0;
+        data.numFromRemainder = 0;
+        data.numAhead = 0;
+    }
+}
+
+/*!
+ * Combine the results of the sub-stream reads.
+ * When every sub-stream reports a timestamp, the skew of each sub-stream
+ * against the first one is recorded and the skew policy is applied:
+ * the leading elements of the early sub-streams are dropped, or leading zeros
+ * are padded into the late sub-streams, so that the output of every channel
+ * starts on the same tick. The result is the common number of elements
+ * in the buffers, and the surplus elements are kept for the next call.
+ * \return the number of elements, 0 to read again, or an error code
+ */
+static int mergeSubStreams(SoapyMultiStreamsData &multiStreams, int &flags, long long &timeNs)
+{
+    //report errors other than timeouts first,
+    //the data read by the other sub-streams is kept for the next call
+    int error = 0;
+    for (const auto &data : multiStreams)
+    {
+        if (data.ret < 0 and (error == 0 or error == SOAPY_SDR_TIMEOUT)) error = data.ret;
+    }
+    if (error != 0)
+    {
+        for (auto &data : multiStreams) consumeSubStream(data, 0);
+        return error;
+    }
+
+    //measure the skew when every sub-stream has a timestamp
+    const auto &front = multiStreams.front();
+    bool timed = multiStreams.size() > 1;
+    for (const auto &data : multiStreams)
+    {
+        if ((data.flags & SOAPY_SDR_HAS_TIME) == 0 or data.rate <= 0.0) timed = false;
+    }
+    long long minTimeNs = front.timeNs;
+    long long maxTimeNs = front.timeNs;
+    for (const auto &data : multiStreams)
+    {
+        if (not timed) break;
+        data.stats->recordSkew(data.timeNs - front.timeNs);
+        minTimeNs = std::min(minTimeNs, data.timeNs);
+        maxTimeNs = std::max(maxTimeNs, data.timeNs);
+    }
+    const long long spreadNs = maxTimeNs - minTimeNs;
+    const bool overThreshold = timed and spreadNs > multiStreams.skewThresholdNs and
+        SoapySDR::timeNsToTicks(spreadNs, front.rate) != 0;
+
+    //only a skew within the window is corrected
+    const auto policy = multiStreams.skewPolicy;
+    bool align = timed and (policy == SOAPY_MULTI_SKEW_DROP or policy == SOAPY_MULTI_SKEW_PAD or policy == SOAPY_MULTI_SKEW_ERROR);
+    if (align and spreadNs > multiStreams.alignWindowNs)
+    {
+        if (not multiStreams.alignWarned) SoapySDR::logf(SOAPY_SDR_WARNING,
+            "SoapyMultiSDR::readStream() sub-stream timestamps differ by %lld ns, not aligning", spreadNs);
+        multiStreams.alignWarned = true;
+        align = false;
+    }
+
+    //at most one warning per second
+    if (overThreshold and policy == SOAPY_MULTI_SKEW_WARN and
+        std::chrono::high_resolution_clock::now() >= multiStreams.skewWarnTime)
+    {
+        SoapySDR::logf(SOAPY_SDR_WARNING, "SoapyMultiSDR::readStream() sub-stream timestamps differ by %lld ns", spreadNs);
+        multiStreams.skewWarnTime = std::chrono::high_resolution_clock::now() + std::chrono::seconds(1);
+    }
+
+    //the latest start time is the alignment point when dropping, the earliest when padding
+    const bool pad = align and policy == SOAPY_MULTI_SKEW_PAD;
+    const long long alignTimeNs = pad?minTimeNs:maxTimeNs;
+
+    //the common number of elements after the dropped or padded elements
+    size_t numElems = front.numElems;
+    std::vector<size_t> numPads(multiStreams.size(), 0);
+    for (size_t i = 0; i < multiStreams.size(); i++)
+    {
+        auto &data = multiStreams[i];
+        const size_t numRead = size_t(data.ret);
+        data.numDrop = 0;
+        if (align and not pad) data.numDrop = std::min(numRead, size_t(SoapySDR::timeNsToTicks(alignTimeNs - data.timeNs, data.rate)));
+        if (pad) numPads[i] = size_t(SoapySDR::timeNsToTicks(data.timeNs - alignTimeNs, data.rate));
+        numElems = std::min(numElems, numPads[i] + numRead - data.numDrop);
+        if (data.numDrop != 0 or numPads[i] != 0) SoapyMultiStats::add(data.stats->realigns);
+        SoapyMultiStats::add(data.stats->dropped, data.numDrop);
+    }
+
+    //keep the aligned elements for the next read, or drop everything which can not be aligned
+    if (overThreshold and policy == SOAPY_MULTI_SKEW_ERROR)
+    {
+        for (auto &data : multiStreams) consumeSubStream(data, align?data.numDrop:size_t(data.ret));
+        return SOAPY_SDR_TIME_ERROR;
+    }
+
+    //nothing in common yet, drop the early elements and read again
+    if (numElems == 0)
+    {
+        for (auto &data : multiStreams) consumeSubStream(data, data.numDrop);
+        return 0;
+    }
+
+    //shift the aligned elements to the front of the buffers
+    for (size_t i = 0; i < multiStreams.size(); i++)
+    {
+        auto &data = multiStreams[i];
+        if (numPads[i] != 0)
+        {
+            //save the surplus before the padding shifts the elements back
+            const size_t numPad = std::min(numPads[i], numElems);
+            consumeSubStream(data, numElems - numPad);
+            for (size_t ch = 0; ch < data.channels.size(); ch++)
+            {
+                auto buff = static_cast<char *>(data.buffs[ch]);
+                std::memmove(buff + numPad*data.elemSize, buff, (numElems - numPad)*data.elemSize);
+                std::memset(buff, 0, numPad*data.elemSize);
+            }
+            SoapyMultiStats::add(data.stats->padded, numPad);
+            continue;
+        }
+        for (size_t ch = 0; ch < data.channels.size() and data.numDrop != 0; ch++)
+        {
+            auto buff = static_cast<char *>(data.buffs[ch]);
+            std::memmove(buff, buff + data.numDrop*data.elemSize, numElems*data.elemSize);
+        }
+        consumeSubStream(data, data.numDrop + numElems);
+    }
+
+    flags = front.flags;
+    timeNs = align?alignTimeNs:front.timeNs;
+    return int(numElems);
+}
+
+//! Convert the numElems merged elements of a converted read into the caller's buffers
+static void convertSubStream(SoapyMultiStreamData &data)
+{
+    if (data.converter.empty()) return;
+    for (size_t ch = 0; ch < data.channels.size(); ch++)
+    {
+        data.converter.convert(data.convertPtrs[ch], data.userBuffs[ch], data.numElems);
+    }
+}
+
+/*******************************************************************
+ * Sub-stream write helpers
+ ******************************************************************/
+
+//! Perform the write on a single sub-stream given the stored arguments
+static void writeSubStream(SoapyMultiStreamData &data)
+{
+    //skip the elements which the device committed on previous calls
+    const size_t numSkip = std::min(data.numAhead, data.numElems);
+    data.ret = 0;
+    if (numSkip == data.numElems) return;
+
+    if (data.converter.empty()) for (size_t ch = 0; ch < data.channels.size(); ch++)
+    {
+        data.aheadBuffs[ch] = static_cast<const char *>(data.writeBuffs[ch]) + numSkip*data.elemSize;
+    }
+
+    //only the elements which were not committed yet are converted
+    else
+    {
+        getConvertBuffs(data, data.numElems-numSkip);
+        for (size_t ch = 0; ch < data.channels.size(); ch++)
+        {
+            const auto in = static_cast<const char *>(data.writeBuffs[ch]) + numSkip*data.converter.inSize();
+            data.converter.convert(in, data.convertPtrs[ch], data.numElems-numSkip);
+            data.aheadBuffs[ch] = data.convertPtrs[ch];
+        }
+    }
+
+    //the timestamp moves along with the skipped elements
+    long long timeNs = data.timeNs;
+    if (numSkip != 0 and (data.flags & SOAPY_SDR_HAS_TIME) != 0)
+    {
+        if (data.rate > 0.0) timeNs += SoapySDR::ticksToTimeNs(numSkip, data.rate);
+        else data.flags &= ~SOAPY_SDR_HAS_TIME;
+    }
+
+    //a write over the MTU is fed to the device in whole MTUs until it is short or the time is up,
+    //only the first chunk carries the timestamp and only the last one the end of burst
+    const size_t numWrite = data.numElems-numSkip;
+    const int inFlags = data.flags;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const auto exitTime = startTime + std::chrono::microseconds(data.timeoutUs);
+    size_t numWritten = 0;
+    while (numWritten < numWrite)
+    {
+        const size_t numChunk = data.coalesce?std::min(numWrite-numWritten, data.mtu):(numWrite-numWritten);
+        data.flags = inFlags;
+        if (numWritten != 0) data.flags &= ~SOAPY_SDR_HAS_TIME;
+        if (numWritten + numChunk != numWrite) data.flags &= ~SOAPY_SDR_END_BURST;
+
+        const long timeoutUs = long(std::chrono::duration_cast<std::chrono::microseconds>(exitTime - startTime).count());
+        const int ret = data.device->writeStream(data.stream, data.aheadBuffs.data(),
+            numChunk, data.flags, timeNs, timeoutUs);
+        const auto endTime = std::chrono::high_resolution_clock::now();
+        data.stats->record(ret, numChunk, std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+
+        //an error after the first chunk is reported by the next call
+        if (ret <= 0)
+        {
+            if (numWritten == 0) data.ret = ret;
+            break;
+        }
+        numWritten += size_t(ret);
+        data.ret = int(numWritten);
+        for (auto &buff : data.aheadBuffs) buff = static_cast<const char *>(buff) + size_t(ret)*data.elemSize;
+        if (size_t(ret) < numChunk or endTime >= exitTime) break;
+        startTime = endTime;
+    }
+}
+
+/*!
+ * Combine the results of the sub-stream writes.
+ * The result is the number of elements committed by every sub-stream,
+ * sub-streams which got further keep a cursor so that the elements
+ * are not sent again when the caller resubmits the rest of the buffer.
+ * \return the number of elements or an error code when nothing was committed
+ */
+static int mergeWrites(SoapyMultiStreamsData &multiStreams, int &flags)
+{
+    //the cursor of a sub-stream may be past the end of a shorter resubmission
+    int error = 0;
+    size_t numElems = multiStreams.front().numElems;
+    for (const auto &data : multiStreams)
+    {
+        const size_t numCommitted = data.numAhead + ((data.ret > 0)?size_t(data.ret):0);
+        numElems = std::min(numElems, numCommitted);
+        if (data.ret < 0 and error == 0) error = data.ret;
+    }
+    for (auto &data : multiStreams)
+    {
+        const size_t numCommitted = data.numAhead + ((data.ret > 0)?size_t(data.ret):0);
+        data.numAhead = numCommitted - numElems;
+    }
+    if (numElems == 0 and error != 0) return error;
+
+    flags = multiStreams.front().flags;
+    return int(numElems);
+}
+
+/*******************************************************************
+ * Stream counters
+ ******************************************************************/
+
+//! The counters of every sub-stream as one JSON object
+static std::string statsToJson(const SoapyMultiStreamsData &multiStreams)
+{
+    std::string json = "{\"index\": " + std::to_string(multiStreams.index);
+    json += ", \"direction\": \"" + std::string((multiStreams.direction == SOAPY_SDR_RX)?"RX":"TX") + "\"";
+    json += ", \"sub_streams\": [";
+    for (const auto &data : multiStreams)
+    {
+        if (&data != &multiStreams.front()) json += ", ";
+        json += "{\"device\": " + std::to_string(data.deviceIndex) + ", \"channels\": [";
+        for (size_t ch = 0; ch < data.channels.size(); ch++)
+        {
+            if (ch != 0) json += ", ";
+            json += std::to_string(data.channels[ch]);
+        }
+        json += "], " + data.stats->toJson() + "}";
+    }
+    return json + "]}";
+}
+
+//! Log the counters as one JSON line when the log interval passed
+static void logStats(SoapyMultiStreamsData &multiStreams)
+{
+    if (multiStreams.statsLogNs <= 0) return;
+    const auto now = std::chrono::high_resolution_clock::now();
+    if (now < multiStreams.statsLogTime) return;
+    multiStreams.statsLogTime = now + std::chrono::nanoseconds(multiStreams.statsLogNs);
+    SoapySDR::logf(SOAPY_SDR_INFO, "SoapyMultiSDR stream stats: %s", statsToJson(multiStreams).c_str());
+}
+
+std::string SoapyMultiSDR::readStreamStats(const size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_streamsMutex);
+    auto it = _streams.find(index);
+    if (it == _streams.end()) throw std::runtime_error("SoapyMultiSDR::readSensor() -- no stream " + std::to_string(index));
+    return statsToJson(*reinterpret_cast<const SoapyMultiStreamsData *>(it->second));
+}
+
+/*******************************************************************
+ * Sub-stream dispatch
+ ******************************************************************/
+
+//! Run the operation on every sub-stream, concurrently for sub-streams with workers
+static void runSubStreams(SoapyMultiStreamsData &multiStreams, void (*operation)(SoapyMultiStreamData &))
+{
+    for (auto &data : multiStreams)
+    {
+        auto &ref = data;
+        if (data.worker) data.worker->post([&ref, operation](void){operation(ref);});
+    }
+    for (auto &data : multiStreams)
+    {
+        if (not data.worker) operation(data);
+    }
+    for (auto &data : multiStreams)
+    {
+        if (data.worker) data.worker->wait();
+    }
+}
+
+/*******************************************************************
+ * Activation helpers
+ ******************************************************************/
+
+/*!
+ * Call the operation for every sub-stream index from a thread per sub-stream.
+ * The threads are released together so that the devices act as close together as possible.
+ * An exception counts as SOAPY_SDR_STREAM_ERROR.
+ * \return the result of the operation for every sub-stream
+ */
+static std::vector<int> forEachSubStream(const SoapyMultiStreamsData &multiStreams, const std::function<int(const size_t)> &operation)
+{
+    std::vector<int> results(multiStreams.size(), 0);
+    SoapyMultiBarrier barrier(multiStreams.size());
+    parallelFor(multiStreams.size(), multiStreams.size(), [&](const size_t i)
+    {
+        barrier.arrive();
+        try {results[i] = operation(i);}
+        catch (const std::exception &ex)
+        {
+            SoapySDR::logf(SOAPY_SDR_ERROR, "SoapyMultiSDR sub-stream %d: %s", int(i), ex.what());
+            results[i] = SOAPY_SDR_STREAM_ERROR;
+        }
+    });
+    return results;
+}
+
+//! The first error in the results or 0
+static int firstError(const std::vector<int> &results)
+{
+    for (const auto ret : results) if (ret != 0) return ret;
+    return 0;
+}
+
+/*******************************************************************
+ * Direct buffer access helpers
+ ******************************************************************/
+
+//! Find a handle which is not acquired, \return false when every handle is outstanding
+static bool findFreeHandle(const SoapyMultiStreamsData &multiStreams, size_t &handle)
+{
+    for (handle = 0; handle < multiStreams.handles.size(); handle++)
+    {
+        const auto &multiHandle = multiStreams.handles[handle];
+        if (not multiHandle.acquired and multiHandle.numPending == 0) return true;
+    }
+    return false;
+}
+
+//! Find the handle of a partial read acquire, \return false when there is none
+static bool findPendingHandle(const SoapyMultiStreamsData &multiStreams, size_t &handle)
+{
+    for (handle = 0; handle < multiStreams.handles.size(); handle++)
+    {
+        if (multiStreams.handles[handle].numPending != 0) return true;
+    }
+    return false;
+}
+
+//! Release the buffers acquired on the first numStreams sub-streams
+static void releaseSubHandles(SoapyMultiStreamsData &multiStreams, const std::vector<size_t> &handles, const size_t numStreams)
+{
+    for (size_t i = 0; i < numStreams; i++)
+    {
+        auto &data = multiStreams[i];
+        if (multiStreams.direction == SOAPY_SDR_RX) data.device->releaseReadBuffer(data.stream, handles[i]);
+        else
+        {
+            //a write buffer released with no elements sends nothing
+            int flags = 0;
+            data.device->releaseWriteBuffer(data.stream, handles[i], 0, flags, 0);
+        }
+    }
+}
+
+//! Release the buffers of partial read acquires, used when the stream stops
+static void releasePendingHandles(SoapyMultiStreamsData &multiStreams)
+{
+    for (auto &multiHandle : multiStreams.handles)
+    {
+        releaseSubHandles(multiStreams, multiHandle.handles, multiHandle.numPending);
+        multiHandle.numPending = 0;
+    }
+}
+
 /*******************************************************************
  * Stream API
  ******************************************************************/
 
 std::vector<std::string> SoapyMultiSDR::getStreamFormats(const int direction, const size_t channel) const
 {
-    size_t localChannel = 0;
-    auto device = this->getDevice(direction, channel, localChannel);
-    return device->getStreamFormats(direction, localChannel);
+    return this->cachedQuery(_namesCache, direction, channel, "getStreamFormats", [&](void)
+    {
+        size_t localChannel = 0;
+        auto device = this->getDevice(direction, channel, localChannel);
+        auto formats = device->getStreamFormats(direction, localChannel);
+
+        //the wrapper converts from the native format into the other formats
+        double fullScale = 0.0;
+        if (not isConvertibleFormat(device->getNativeStreamFormat(direction, localChannel, fullScale))) return formats;
+        for (const auto &format : {SOAPY_SDR_CF64, SOAPY_SDR_CF32, SOAPY_SDR_CS16, SOAPY_SDR_CS12, SOAPY_SDR_CS8})
+        {
+            if (std::find(formats.begin(), formats.end(), format) == formats.end()) formats.push_back(format);
+        }
+        return formats;
+    });
 }
 
 std::string SoapyMultiSDR::getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const
@@ -37,7 +1103,154 @@ SoapySDR::ArgInfoList SoapyMultiSDR::getStreamArgsInfo(const int direction, cons
 {
     size_t localChannel = 0;
     auto device = this->getDevice(direction, channel, localChannel);
-    return device->getStreamArgsInfo(direction, localChannel);
+    auto result = device->getStreamArgsInfo(direction, localChannel);
+
+    //stream args which configure the wrapper
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "parallel";
+        info.value = "false";
+        info.name = "Parallel";
+        info.description = "Service each sub-device stream with a dedicated worker thread.";
+        info.type = SoapySDR::ArgInfo::BOOL;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "align";
+        info.value = "true";
+        info.name = "Align";
+        info.description = "Drop leading elements so that every sub-device read starts on the same timestamp.";
+        info.type = SoapySDR::ArgInfo::BOOL;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "skew_policy";
+        info.value = "drop";
+        info.name = "Skew Policy";
+        info.description = "What a read does when the sub-device timestamps differ: "
+            "drop the leading elements of the early devices, pad the late devices with zeros, "
+            "warn or fail the read when the skew exceeds the threshold, or ignore the skew. "
+            "Setting align to false is the same as ignore.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        info.options = {"drop", "pad", "warn", "error", "ignore"};
+        info.optionNames = {"Drop", "Pad", "Warn", "Error", "Ignore"};
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "skew_threshold_us";
+        info.value = "0";
+        info.name = "Skew Threshold";
+        info.description = "Largest timestamp difference which does not warn or fail the read, at least one element.";
+        info.units = "us";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "align_window_ms";
+        info.value = "1000";
+        info.name = "Align Window";
+        info.description = "Largest timestamp difference which is corrected by alignment.";
+        info.units = "ms";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "native";
+        info.value = "false";
+        info.name = "Native Format";
+        info.description = "Stream every sub-device in its native format and convert in the wrapper, "
+            "otherwise only sub-devices which do not support the stream format are converted.";
+        info.type = SoapySDR::ArgInfo::BOOL;
+        result.push_back(info);
+    }
+    if (direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "layout";
+        info.value = "channels";
+        info.name = "Layout";
+        info.description = "Read one buffer per channel, or one buffer with the channels interleaved per element.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        info.options = {"channels", "interleaved"};
+        info.optionNames = {"Channels", "Interleaved"};
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "mtu";
+        info.value = "min";
+        info.name = "MTU";
+        info.description = "Report the smallest sub-device MTU, "
+            "or the smallest size which is a whole number of MTUs on every sub-device.";
+        info.type = SoapySDR::ArgInfo::STRING;
+        info.options = {"min", "lcm"};
+        info.optionNames = {"Minimum", "LCM"};
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "coalesce";
+        info.value = "false";
+        info.name = "Coalesce";
+        info.description = "Read a whole MTU from a sub-device when less is requested and keep the surplus for the next read, "
+            "and write more than an MTU to a sub-device in MTU chunks within one call.";
+        info.type = SoapySDR::ArgInfo::BOOL;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "start_margin_ms";
+        info.value = "0";
+        info.name = "Start Margin";
+        info.description = "When activate is called without a time, "
+            "start every sub-device at the hardware time plus this margin, "
+            "so that all of them start on the same tick. The sub-devices must share a time base. "
+            "0 to start each sub-device as soon as it is called.";
+        info.units = "ms";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "stop_margin_ms";
+        info.value = "0";
+        info.name = "Stop Margin";
+        info.description = "When deactivate is called without a time, "
+            "stop every sub-device at the hardware time plus this margin. "
+            "Only for sub-devices which support a timed deactivate. "
+            "0 to stop each sub-device as soon as it is called.";
+        info.units = "ms";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "stats_log_ms";
+        info.value = "0";
+        info.name = "Statistics Log";
+        info.description = "Log the stream counters as a JSON line at this interval, 0 to disable.";
+        info.units = "ms";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+    if (direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = SOAPY_MULTI_KWARG_PREFIX "buffer_ms";
+        info.value = "0";
+        info.name = "Buffer Depth";
+        info.description = "Read each sub-device continuously in the background into a ring of this depth, 0 to disable.";
+        info.units = "ms";
+        info.type = SoapySDR::ArgInfo::INT;
+        result.push_back(info);
+    }
+
+    return result;
 }
 
 SoapySDR::Stream *SoapyMultiSDR::setupStream(
@@ -50,37 +1263,163 @@ SoapySDR::Stream *SoapyMultiSDR::setupStream(
     std::vector<size_t> channels(channels_);
     if (channels.empty()) channels.push_back(0);
 
-    //stream the data structure
-    auto multiStreams = new SoapyMultiStreamsData();
+    //wrapper options are not passed to the sub-streams
+    SoapySDR::Kwargs subArgs;
+    const auto multiArgs = splitMultiArgs(args, subArgs);
+    const bool parallel = multiArgs.count("parallel") != 0 and multiArgs.at("parallel") == "true";
+    const bool native = multiArgs.count("native") != 0 and multiArgs.at("native") == "true";
+    const bool coalesce = multiArgs.count("coalesce") != 0 and multiArgs.at("coalesce") == "true";
+    const std::string mtuPolicy = (multiArgs.count("mtu") != 0)?multiArgs.at("mtu"):"min";
+    const long long startMarginNs = (multiArgs.count("start_margin_ms") != 0)?std::stoll(multiArgs.at("start_margin_ms"))*1000000:0;
+    const long long stopMarginNs = (multiArgs.count("stop_margin_ms") != 0)?std::stoll(multiArgs.at("stop_margin_ms"))*1000000:0;
+    if (mtuPolicy != "min" and mtuPolicy != "lcm") throw std::runtime_error("SoapyMultiSDR::setupStream() -- unknown mtu " + mtuPolicy);
 
-    //iterate through the channels to fill the data structure
-    for (const auto &channel : channels)
+    //stream the data structure, owned here until it is returned so a bad arg does not leak it
+    std::unique_ptr<SoapyMultiStreamsData> multiStreams(new SoapyMultiStreamsData());
+    multiStreams->direction = direction;
+    multiStreams->skewPolicy = SOAPY_MULTI_SKEW_DROP;
+    const std::string skewPolicy = (multiArgs.count("skew_policy") != 0)?multiArgs.at("skew_policy"):"drop";
+    if (skewPolicy == "pad") multiStreams->skewPolicy = SOAPY_MULTI_SKEW_PAD;
+    else if (skewPolicy == "warn") multiStreams->skewPolicy = SOAPY_MULTI_SKEW_WARN;
+    else if (skewPolicy == "error") multiStreams->skewPolicy = SOAPY_MULTI_SKEW_ERROR;
+    else if (skewPolicy == "ignore") multiStreams->skewPolicy = SOAPY_MULTI_SKEW_IGNORE;
+    else if (skewPolicy != "drop") throw std::runtime_error("SoapyMultiSDR::setupStream() -- unknown skew_policy " + skewPolicy);
+    if (multiArgs.count("align") != 0 and multiArgs.at("align") == "false") multiStreams->skewPolicy = SOAPY_MULTI_SKEW_IGNORE;
+    multiStreams->skewThresholdNs = 0;
+    if (multiArgs.count("skew_threshold_us") != 0) multiStreams->skewThresholdNs = std::stoll(multiArgs.at("skew_threshold_us"))*1000;
+    multiStreams->skewWarnTime = std::chrono::high_resolution_clock::now();
+    multiStreams->alignWindowNs = 1000000000;
+    if (multiArgs.count("align_window_ms") != 0) multiStreams->alignWindowNs = std::stoll(multiArgs.at("align_window_ms"))*1000000;
+    multiStreams->alignWarned = false;
+    multiStreams->bufferNs = 0;
+    multiStreams->startMarginNs = startMarginNs;
+    multiStreams->stopMarginNs = stopMarginNs;
+    multiStreams->convert = false;
+    multiStreams->interleaved = direction == SOAPY_SDR_RX and multiArgs.count("layout") != 0 and multiArgs.at("layout") == "interleaved";
+    multiStreams->elemSize = SoapySDR::formatToSize(format);
+    if (multiStreams->interleaved) multiStreams->layoutBuffs.resize(channels.size());
+    multiStreams->layoutPtrs.resize(multiStreams->layoutBuffs.size());
+    multiStreams->statsLogNs = 0;
+    if (multiArgs.count("stats_log_ms") != 0) multiStreams->statsLogNs = std::stoll(multiArgs.at("stats_log_ms"))*1000000;
+    multiStreams->statsLogTime = std::chrono::high_resolution_clock::now();
+    if (direction == SOAPY_SDR_RX and multiArgs.count("buffer_ms") != 0) multiStreams->bufferNs = std::stoll(multiArgs.at("buffer_ms"))*1000000;
+
+    //one sub-stream per device with the channels of that device
+    for (const auto &group : this->getChanMap(direction).group(channels))
     {
-        size_t localChannel = 0;
-        auto device = this->getDevice(direction, channel, localChannel);
-        if (multiStreams->empty() or multiStreams->back().device != device)
+        multiStreams->resize(multiStreams->size()+1);
+        auto &multiStream = multiStreams->back();
+        multiStream.device = _devices[group.deviceIndex];
+        multiStream.deviceIndex = group.deviceIndex;
+        multiStream.stream = nullptr;
+        multiStream.channels = group.localChannels;
+        multiStream.buffIndexes = group.buffIndexes;
+        multiStream.contiguous = group.contiguous;
+        multiStream.route.resize(group.localChannels.size());
+        multiStream.constRoute.resize(group.localChannels.size());
+    }
+
+    //create the streams, the ones already created are closed again when one fails
+    for (auto &multiStream : *multiStreams) try
+    {
+        //use the native format when the device can not stream the format itself
+        auto subFormat = format;
+        double fullScale = 0.0;
+        const auto localChannel = multiStream.channels.front();
+        const auto nativeFormat = multiStream.device->getNativeStreamFormat(direction, localChannel, fullScale);
+        const auto formats = multiStream.device->getStreamFormats(direction, localChannel);
+        const bool supported = std::find(formats.begin(), formats.end(), format) != formats.end();
+        if ((native or not supported) and nativeFormat != format and isConvertibleFormat(nativeFormat) and isConvertibleFormat(format))
+        {
+            if (fullScale <= 0.0) fullScale = nominalFullScale(nativeFormat);
+            subFormat = nativeFormat;
+            multiStream.converter = (direction == SOAPY_SDR_RX)?
+                SoapyMultiConverter(nativeFormat, fullScale, format, nominalFullScale(format)):
+                SoapyMultiConverter(format, nominalFullScale(format), nativeFormat, fullScale);
+            multiStream.convertBuffs.resize(multiStream.channels.size());
+            multiStream.convertPtrs.resize(multiStream.channels.size());
+            multiStreams->convert = true;
+        }
+
+        multiStream.stream = multiStream.device->setupStream(
+            direction, subFormat, multiStream.channels, subArgs);
+        multiStream.elemSize = SoapySDR::formatToSize(subFormat);
+        multiStream.rate = 0.0;
+        multiStream.mtu = std::max<size_t>(multiStream.device->getStreamMTU(multiStream.stream), 1);
+        multiStream.coalesce = coalesce;
+        if (direction == SOAPY_SDR_RX and coalesce) for (size_t ch = 0; ch < multiStream.channels.size(); ch++)
         {
-            multiStreams->resize(multiStreams->size()+1);
+            multiStream.stageBuffs.emplace_back(multiStream.mtu*multiStream.elemSize);
+            multiStream.stagePtrs.push_back(multiStream.stageBuffs.back().data());
         }
-        multiStreams->back().device = device;
-        multiStreams->back().channels.push_back(localChannel);
+        multiStream.remainder.resize(multiStream.channels.size());
+        multiStream.numRemainder = 0;
+        multiStream.numFromRemainder = 0;
+        multiStream.readBuffs.resize(multiStream.channels.size());
+        multiStream.numAhead = 0;
+        multiStream.aheadBuffs.resize(multiStream.channels.size());
+        multiStream.stats.reset(new SoapyMultiStats());
+    }
+    catch (...)
+    {
+        for (auto &other : *multiStreams)
+        {
+            if (other.stream != nullptr) other.device->closeStream(other.stream);
+        }
+        throw;
     }
 
-    //create the streams
+    multiStreams->mtu = aggregateMTU(*multiStreams, mtuPolicy == "lcm");
+
+    //every direct access handle maps to one buffer on each sub-stream
+    auto &multiStream0 = multiStreams->front();
+    size_t numHandles = multiStream0.device->getNumDirectAccessBuffers(multiStream0.stream);
     for (auto &multiStream : *multiStreams)
     {
-        multiStream.stream = multiStream.device->setupStream(
-            direction, format, multiStream.channels, args);
+        numHandles = std::min(numHandles, multiStream.device->getNumDirectAccessBuffers(multiStream.stream));
+    }
+    if (multiStreams->convert or multiStreams->interleaved) numHandles = 0; //the buffers are not in the stream layout
+    multiStreams->handles.resize(numHandles);
+    for (auto &handle : multiStreams->handles)
+    {
+        handle.acquired = false;
+        handle.handles.resize(multiStreams->size());
+        handle.numPending = 0;
+        handle.pendingRet = 0;
+        handle.pendingFlags = 0;
+        handle.pendingTimeNs = 0;
+        handle.pendingBuffs.resize(channels.size());
     }
 
-    return reinterpret_cast<SoapySDR::Stream *>(multiStreams);
+    //the first sub-stream is always serviced by the calling thread
+    for (size_t i = 1; parallel and i < multiStreams->size(); i++)
+    {
+        multiStreams->at(i).worker.reset(new SoapyMultiWorker());
+    }
+
+    //register the stream for the stream_stats sensor
+    std::lock_guard<std::mutex> lock(_streamsMutex);
+    multiStreams->index = _nextStreamIndex++;
+    _streams[multiStreams->index] = reinterpret_cast<SoapySDR::Stream *>(multiStreams.get());
+
+    return reinterpret_cast<SoapySDR::Stream *>(multiStreams.release());
 }
 
 void SoapyMultiSDR::closeStream(SoapySDR::Stream *stream)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    {
+        std::lock_guard<std::mutex> lock(_streamsMutex);
+        _streams.erase(multiStreams->index);
+    }
+    {
+        std::lock_guard<std::mutex> lock(multiStreams->statusMutex);
+        stopStatus(*multiStreams);
+    }
+    releasePendingHandles(*multiStreams);
     for (auto &multiStream : *multiStreams)
     {
+        stopReader(multiStream);
         multiStream.device->closeStream(multiStream.stream);
     }
     delete multiStreams;
@@ -89,8 +1428,7 @@ void SoapyMultiSDR::closeStream(SoapySDR::Stream *stream)
 size_t SoapyMultiSDR::getStreamMTU(SoapySDR::Stream *stream) const
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
-    const auto &stream0 = multiStreams->front();
-    return stream0.device->getStreamMTU(stream0.stream);
+    return multiStreams->mtu;
 }
 
 int SoapyMultiSDR::activateStream(
@@ -100,11 +1438,52 @@ int SoapyMultiSDR::activateStream(
     const size_t numElems)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    clearSubStreams(*multiStreams);
+
+    //the rate converts timestamp differences into elements
     for (auto &multiStream : *multiStreams)
     {
-        int ret = multiStream.device->activateStream(multiStream.stream, flags, timeNs, numElems);
-        if (ret != 0) return ret;
+        multiStream.rate = multiStream.device->getSampleRate(multiStreams->direction, multiStream.channels.front());
+    }
+
+    //a coordinated start picks a time in the near future for every device
+    int subFlags = flags;
+    long long subTimeNs = timeNs;
+    if (multiStreams->startMarginNs > 0 and (flags & SOAPY_SDR_HAS_TIME) == 0)
+    {
+        if (not this->hasHardwareTime("")) return SOAPY_SDR_NOT_SUPPORTED;
+        subFlags |= SOAPY_SDR_HAS_TIME;
+        subTimeNs = this->getHardwareTime("") + multiStreams->startMarginNs;
+    }
+
+    const auto results = forEachSubStream(*multiStreams, [&](const size_t i)
+    {
+        auto &multiStream = multiStreams->at(i);
+        return multiStream.device->activateStream(multiStream.stream, subFlags, subTimeNs, numElems);
+    });
+
+    //a failed start leaves no device streaming
+    const int error = firstError(results);
+    if (error != 0)
+    {
+        forEachSubStream(*multiStreams, [&](const size_t i)
+        {
+            auto &multiStream = multiStreams->at(i);
+            return (results[i] == 0)?multiStream.device->deactivateStream(multiStream.stream, 0, 0):0;
+        });
+        return error;
+    }
+
+    //the readers start once every sub-stream is active
+    for (auto &multiStream : *multiStreams)
+    {
+        stopReader(multiStream);
+        if (multiStreams->bufferNs > 0) startReader(multiStream, multiStreams->bufferNs);
     }
+
+    //the status is polled again when it was polled before the deactivation
+    std::lock_guard<std::mutex> lock(multiStreams->statusMutex);
+    if (multiStreams->status) startStatus(*multiStreams);
     return 0;
 }
 
@@ -114,12 +1493,32 @@ int SoapyMultiSDR::deactivateStream(
     const long long timeNs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
-    for (auto &multiStream : *multiStreams)
+    for (auto &multiStream : *multiStreams) stopReader(multiStream);
+    releasePendingHandles(*multiStreams);
+
+    //a coordinated stop is only asked for explicitly, many devices do not support a timed stop
+    int subFlags = flags;
+    long long subTimeNs = timeNs;
+    if (multiStreams->stopMarginNs > 0 and (flags & SOAPY_SDR_HAS_TIME) == 0 and this->hasHardwareTime(""))
     {
-        int ret = multiStream.device->deactivateStream(multiStream.stream, flags, timeNs);
-        if (ret != 0) return ret;
+        subFlags |= SOAPY_SDR_HAS_TIME;
+        subTimeNs = this->getHardwareTime("") + multiStreams->stopMarginNs;
     }
-    return 0;
+
+    //every device is stopped even when one of them fails
+    const auto results = forEachSubStream(*multiStreams, [&](const size_t i)
+    {
+        auto &multiStream = multiStreams->at(i);
+        return multiStream.device->deactivateStream(multiStream.stream, subFlags, subTimeNs);
+    });
+    clearSubStreams(*multiStreams);
+
+    //an inactive stream is not polled for status, the events queued so far can still be read
+    {
+        std::lock_guard<std::mutex> lock(multiStreams->statusMutex);
+        stopStatus(*multiStreams);
+    }
+    return firstError(results);
 }
 
 int SoapyMultiSDR::readStream(
@@ -131,40 +1530,54 @@ int SoapyMultiSDR::readStream(
     const long timeoutUs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(timeoutUs);
+    long timeoutLeftUs = timeoutUs;
+    logStats(*multiStreams);
 
-    int ret = 0;
-    int offset = 0;
-    int originalFlags = flags;
-    int flagsOut = 0;
-    long long timeNsOut = 0;
+    //the interleaved output is assembled from a buffer per channel
+    void * const *channelBuffs = buffs;
+    if (multiStreams->interleaved)
+    {
+        for (size_t ch = 0; ch < multiStreams->layoutBuffs.size(); ch++)
+        {
+            auto &buff = multiStreams->layoutBuffs[ch];
+            buff.resize(std::max(buff.size(), numElems*multiStreams->elemSize));
+            multiStreams->layoutPtrs[ch] = buff.data();
+        }
+        channelBuffs = multiStreams->layoutPtrs.data();
+    }
 
-    for (auto &multiStream : *multiStreams)
+    while (true)
     {
-        flags = originalFlags; //restore flags before each call
-        ret = multiStream.device->readStream(multiStream.stream,
-            buffs+offset, numElems, flags, timeNs, timeoutUs);
-        if (ret <= 0) return ret;
+        //each sub-stream reads with the original flags into the buffers of its channels
+        for (auto &multiStream : *multiStreams)
+        {
+            multiStream.buffs = gatherBuffs(multiStream, channelBuffs, multiStream.route);
+            multiStream.numElems = numElems;
+            multiStream.flags = flags;
+            multiStream.timeNs = 0;
+            multiStream.timeoutUs = timeoutLeftUs;
+        }
 
-        //on the first readStream, store the output flags and time
-        if (offset == 0)
+        runSubStreams(*multiStreams, &readSubStream);
+        const int ret = mergeSubStreams(*multiStreams, flags, timeNs);
+        if (ret > 0 and multiStreams->convert)
         {
-            flagsOut = flags;
-            timeNsOut = timeNs;
+            for (auto &multiStream : *multiStreams) multiStream.numElems = size_t(ret);
+            runSubStreams(*multiStreams, &convertSubStream);
         }
+        if (ret > 0 and multiStreams->interleaved)
+        {
+            interleaveChannels(multiStreams->layoutPtrs.data(), multiStreams->layoutPtrs.size(),
+                buffs[0], size_t(ret), multiStreams->elemSize);
+        }
+        if (ret != 0) return ret;
 
-        offset += multiStream.channels.size();
+        //the sub-streams are still being aligned, read again in the remaining time
+        timeoutLeftUs = long(std::chrono::duration_cast<std::chrono::microseconds>(
+            exitTime - std::chrono::high_resolution_clock::now()).count());
+        if (timeoutLeftUs <= 0) return SOAPY_SDR_TIMEOUT;
     }
-
-    //Note: ret represents the last read number of elements
-    //this should be homogeneous, but if not, this implementation
-    //should be improved to handle different length reads
-    //by saving the remainder and writing it into the buffer
-    //on subsequent calls and performing other book-keeping tasks.
-
-    //setup the result
-    flags = flagsOut;
-    timeNs = timeNsOut;
-    return ret;
 }
 
 int SoapyMultiSDR::writeStream(
@@ -176,34 +1589,20 @@ int SoapyMultiSDR::writeStream(
     const long timeoutUs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    logStats(*multiStreams);
 
-    int ret = 0;
-    int offset = 0;
-    int originalFlags = flags;
-    int flagsOut = 0;
-
+    //each sub-stream writes with the original flags from the buffers of its channels
     for (auto &multiStream : *multiStreams)
     {
-        flags = originalFlags; //restore flags before each call
-        ret = multiStream.device->writeStream(multiStream.stream,
-            buffs+offset, numElems, flags, timeNs, timeoutUs);
-        if (ret <= 0) return ret;
-
-        //on the first writeStream, store the output flags
-        if (offset == 0) flagsOut = flags;
-
-        offset += multiStream.channels.size();
+        multiStream.writeBuffs = gatherBuffs(multiStream, buffs, multiStream.constRoute);
+        multiStream.numElems = numElems;
+        multiStream.flags = flags;
+        multiStream.timeNs = timeNs;
+        multiStream.timeoutUs = timeoutUs;
     }
 
-    //Note: ret represents the last written number of elements
-    //this should be homogeneous, but if not, this implementation
-    //should be improved to handle different length writes
-    //by saving the remainder and reading it from the buffer
-    //on subsequent calls and performing other book-keeping tasks.
-
-    //setup the result
-    flags = flagsOut;
-    return ret;
+    runSubStreams(*multiStreams, &writeSubStream);
+    return mergeWrites(*multiStreams, flags);
 }
 
 int SoapyMultiSDR::readStreamStatus(
@@ -215,22 +1614,27 @@ int SoapyMultiSDR::readStreamStatus(
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
 
-    int ret = 0;
-    size_t offset = 0;
-    for (auto &multiStream : *multiStreams)
+    //the sub-streams are polled concurrently from the first call until the stream is deactivated
     {
-        ret = multiStream.device->readStreamStatus(multiStream.stream,
-            chanMask, flags, timeNs, timeoutUs);
-
-        chanMask <<= offset; //mask bits shifted up for global channel mapping
-
-        if (ret == 0) return ret; //status message found
-
-        offset += multiStream.channels.size();
+        std::lock_guard<std::mutex> lock(multiStreams->statusMutex);
+        if (not multiStreams->status) startStatus(*multiStreams);
     }
+    auto &status = *multiStreams->status;
 
-    //return last-seen error code (probably timeout or not supported)
-    return ret;
+    //wait for the next event from any sub-stream
+    std::unique_lock<std::mutex> lock(status.mutex);
+    status.cond.wait_for(lock, std::chrono::microseconds(timeoutUs), [&status](void)
+    {
+        return not status.events.empty() or status.numPolling == 0;
+    });
+    if (status.events.empty()) return (status.numPolling == 0)?SOAPY_SDR_NOT_SUPPORTED:SOAPY_SDR_TIMEOUT;
+
+    const auto event = status.events.front();
+    status.events.pop_front();
+    chanMask = event.chanMask;
+    flags = event.flags;
+    timeNs = event.timeNs;
+    return event.ret;
 }
 
 /*******************************************************************
@@ -240,20 +1644,26 @@ int SoapyMultiSDR::readStreamStatus(
 size_t SoapyMultiSDR::getNumDirectAccessBuffers(SoapySDR::Stream *stream)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
-    auto &multiStream0 = multiStreams->front();
-    return multiStream0.device->getNumDirectAccessBuffers(multiStream0.stream);
+    if (multiStreams->bufferNs > 0) return 0; //the background readers own the sub-streams
+    return multiStreams->handles.size();
 }
 
 int SoapyMultiSDR::getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    if (handle >= multiStreams->handles.size()) return SOAPY_SDR_NOT_SUPPORTED;
 
-    size_t offset = 0;
-    for (auto &multiStream : *multiStreams)
+    //an acquired handle maps to the buffers of the sub-streams,
+    //otherwise the handle is the buffer index on every sub-stream
+    const auto &multiHandle = multiStreams->handles[handle];
+    for (size_t i = 0; i < multiStreams->size(); i++)
     {
-        int ret = multiStream.device->getDirectAccessBufferAddrs(multiStream.stream, handle, buffs+offset);
+        auto &multiStream = multiStreams->at(i);
+        const size_t subHandle = multiHandle.acquired?multiHandle.handles[i]:handle;
+        int ret = multiStream.device->getDirectAccessBufferAddrs(multiStream.stream, subHandle,
+            routeBuffs(multiStream, buffs, multiStream.route));
         if (ret != 0) return ret;
-        offset += multiStream.channels.size();
+        scatterBuffs(multiStream, buffs, multiStream.route);
     }
 
     return 0;
@@ -268,31 +1678,62 @@ int SoapyMultiSDR::acquireReadBuffer(
     const long timeoutUs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    if (multiStreams->bufferNs > 0) return SOAPY_SDR_NOT_SUPPORTED;
+    if (multiStreams->handles.empty()) return SOAPY_SDR_NOT_SUPPORTED;
 
-    int ret = 0;
-    int offset = 0;
+    //a partial acquire is resumed before another handle is used
+    if (not findPendingHandle(*multiStreams, handle) and not findFreeHandle(*multiStreams, handle)) return SOAPY_SDR_TIMEOUT;
+    auto &multiHandle = multiStreams->handles[handle];
+
+    //every sub-stream waits within the same timeout
+    const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(timeoutUs);
+
+    int ret = multiHandle.pendingRet;
     int originalFlags = flags;
-    int flagsOut = 0;
-    long long timeNsOut = 0;
+    int flagsOut = multiHandle.pendingFlags;
+    long long timeNsOut = multiHandle.pendingTimeNs;
 
-    for (auto &multiStream : *multiStreams)
+    //the buffers of the sub-streams acquired by an earlier call
+    for (size_t i = 0; i < multiHandle.numPending; i++)
+    {
+        for (const auto buffIndex : multiStreams->at(i).buffIndexes) buffs[buffIndex] = multiHandle.pendingBuffs[buffIndex];
+    }
+
+    for (size_t i = multiHandle.numPending; i < multiStreams->size(); i++)
     {
+        auto &multiStream = multiStreams->at(i);
         flags = originalFlags; //restore flags before each call
-        ret = multiStream.device->acquireReadBuffer(multiStream.stream,
-            handle, buffs+offset, flags, timeNs, timeoutUs);
-        if (ret <= 0) return ret;
+        const int ret_i = multiStream.device->acquireReadBuffer(multiStream.stream,
+            multiHandle.handles[i], routeBuffs(multiStream, buffs, multiStream.constRoute), flags, timeNs, timeLeftUs(exitTime));
+
+        //keep the buffers already acquired from the other sub-streams for the next call,
+        //releasing them would drop their samples from only some of the channels
+        if (ret_i <= 0)
+        {
+            multiHandle.numPending = i;
+            multiHandle.pendingRet = ret;
+            multiHandle.pendingFlags = flagsOut;
+            multiHandle.pendingTimeNs = timeNsOut;
+            return ret_i;
+        }
+
+        scatterBuffs(multiStream, buffs, multiStream.constRoute);
+        for (const auto buffIndex : multiStream.buffIndexes) multiHandle.pendingBuffs[buffIndex] = buffs[buffIndex];
 
         //on the first readStream, store the output flags and time
-        if (offset == 0)
+        if (i == 0)
         {
             flagsOut = flags;
             timeNsOut = timeNs;
         }
 
-        offset += multiStream.channels.size();
+        //only the elements which are in every buffer are usable
+        ret = (i == 0)?ret_i:std::min(ret, ret_i);
     }
 
     //setup the result
+    multiHandle.numPending = 0;
+    multiHandle.acquired = true;
     flags = flagsOut;
     timeNs = timeNsOut;
     return ret;
@@ -303,11 +1744,12 @@ void SoapyMultiSDR::releaseReadBuffer(
     const size_t handle)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    if (handle >= multiStreams->handles.size()) return;
+    auto &multiHandle = multiStreams->handles[handle];
+    if (not multiHandle.acquired) return;
 
-    for (auto &multiStream : *multiStreams)
-    {
-        multiStream.device->releaseReadBuffer(multiStream.stream, handle);
-    }
+    releaseSubHandles(*multiStreams, multiHandle.handles, multiStreams->size());
+    multiHandle.acquired = false;
 }
 
 int SoapyMultiSDR::acquireWriteBuffer(
@@ -317,17 +1759,33 @@ int SoapyMultiSDR::acquireWriteBuffer(
     const long timeoutUs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    if (multiStreams->handles.empty()) return SOAPY_SDR_NOT_SUPPORTED;
+    if (not findFreeHandle(*multiStreams, handle)) return SOAPY_SDR_TIMEOUT;
+    auto &multiHandle = multiStreams->handles[handle];
+
+    //every sub-stream waits within the same timeout
+    const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(timeoutUs);
 
     int ret = 0;
-    int offset = 0;
 
-    for (auto &multiStream : *multiStreams)
+    for (size_t i = 0; i < multiStreams->size(); i++)
     {
-        multiStream.device->acquireWriteBuffer(multiStream.stream, handle, buffs+offset, timeoutUs);
-        if (ret <= 0) return ret;
-        offset += multiStream.channels.size();
+        auto &multiStream = multiStreams->at(i);
+        const int ret_i = multiStream.device->acquireWriteBuffer(multiStream.stream,
+            multiHandle.handles[i], routeBuffs(multiStream, buffs, multiStream.route), timeLeftUs(exitTime));
+
+        //give back the buffers already acquired from the other sub-streams
+        if (ret_i <= 0)
+        {
+            releaseSubHandles(*multiStreams, multiHandle.handles, i);
+            return ret_i;
+        }
+
+        scatterBuffs(multiStream, buffs, multiStream.route);
+        ret = (i == 0)?ret_i:std::min(ret, ret_i);
     }
 
+    multiHandle.acquired = true;
     return ret;
 }
 
@@ -339,22 +1797,24 @@ void SoapyMultiSDR::releaseWriteBuffer(
     const long long timeNs)
 {
     auto multiStreams = reinterpret_cast<SoapyMultiStreamsData *>(stream);
+    if (handle >= multiStreams->handles.size()) return;
+    auto &multiHandle = multiStreams->handles[handle];
+    if (not multiHandle.acquired) return;
 
-    int offset = 0;
     int originalFlags = flags;
     int flagsOut = 0;
 
-    for (auto &multiStream : *multiStreams)
+    for (size_t i = 0; i < multiStreams->size(); i++)
     {
+        auto &multiStream = multiStreams->at(i);
         flags = originalFlags; //restore flags before each call
-        multiStream.device->releaseWriteBuffer(multiStream.stream, handle, numElems, flags, timeNs);
+        multiStream.device->releaseWriteBuffer(multiStream.stream, multiHandle.handles[i], numElems, flags, timeNs);
 
         //on the first writeStream, store the output flags
-        if (offset == 0) flagsOut = flags;
-
-        offset += multiStream.channels.size();
+        if (i == 0) flagsOut = flags;
     }
 
     //setup the result
+    multiHandle.acquired = false;
     flags = flagsOut;
 }
@@ -0,0 +1,76 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the channel map, and the routing of reordered stream channels
+ * with mock devices.
+ **********************************************************************/
+
+#include "MultiChannelUtils.hpp"
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <iostream>
+#include <complex>
+#include <memory>
+#include <cstdlib>
+
+//! Read from devices with 2 channels each, the real part of the ramp tells the device apart
+static int testReorderedRead(const std::vector<size_t> &channels)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2", "channels=2,ticks=10000"}));
+
+    SoapySDR::Kwargs streamArgs;
+    streamArgs["multi:skew_policy"] = "ignore";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, channels, streamArgs);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::vector<std::complex<float>>> buffs(channels.size(), std::vector<std::complex<float>>(100));
+    std::vector<void *> ptrs;
+    for (auto &buff : buffs) ptrs.push_back(buff.data());
+    int flags = 0;
+    long long timeNs = 0;
+    int result = EXIT_SUCCESS;
+    if (device->readStream(stream, ptrs.data(), 100, flags, timeNs, 100000) <= 0) result = EXIT_FAILURE;
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        const float ticks = (channels[i] < 2)?0.0f:10000.0f;
+        if (buffs[i][0] != std::complex<float>(ticks, float(channels[i] % 2))) result = EXIT_FAILURE;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+int main(void)
+{
+    SoapyMultiChannelMap map;
+    map.reload({2, 0, 3});
+
+    std::cout << "test SoapyMultiChannelMap lookup..." << std::endl;
+    if (map.size() != 5) return EXIT_FAILURE;
+    if (map.at(1).deviceIndex != 0 or map.at(1).localChannel != 1) return EXIT_FAILURE;
+    if (map.at(4).deviceIndex != 2 or map.at(4).localChannel != 2) return EXIT_FAILURE;
+    if (map.toGlobal(2, 1) != 3) return EXIT_FAILURE;
+    if (map.firstChannel(2) != 2 or map.numChannels(1) != 0) return EXIT_FAILURE;
+    try
+    {
+        map.at(5); //should throw
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &ex){}
+
+    std::cout << "test SoapyMultiChannelMap::group()..." << std::endl;
+    const auto groups = map.group({3, 0, 2, 4});
+    if (groups.size() != 2) return EXIT_FAILURE;
+    if (groups[0].deviceIndex != 2 or groups[0].localChannels != std::vector<size_t>({1, 0, 2})) return EXIT_FAILURE;
+    if (groups[0].buffIndexes != std::vector<size_t>({0, 2, 3}) or groups[0].contiguous) return EXIT_FAILURE;
+    if (groups[1].deviceIndex != 0 or groups[1].buffIndexes != std::vector<size_t>({1}) or not groups[1].contiguous) return EXIT_FAILURE;
+
+    std::cout << "test readStream() reordered channels..." << std::endl;
+    if (testReorderedRead({0, 1, 2, 3}) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testReorderedRead({3, 0, 2}) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testReorderedRead({2, 1, 0, 3}) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
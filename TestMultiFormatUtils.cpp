@@ -0,0 +1,85 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "MultiFormatUtils.hpp"
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+//! Convert a full-scale ramp through the format and back to CF32
+static bool testRoundTrip(const std::string &format, const double fullScale, const double tolerance)
+{
+    //an odd length exercises the scalar tail of the vector kernels
+    const size_t numElems = 1001;
+    std::vector<float> in(numElems*2), out(numElems*2);
+    for (size_t i = 0; i < in.size(); i++) in[i] = float(2.0*i/in.size() - 1.0);
+
+    std::vector<char> mid(numElems*SoapySDR::formatToSize(format));
+    SoapyMultiConverter(SOAPY_SDR_CF32, 1.0, format, fullScale).convert(in.data(), mid.data(), numElems);
+    SoapyMultiConverter(format, fullScale, SOAPY_SDR_CF32, 1.0).convert(mid.data(), out.data(), numElems);
+
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        if (std::abs(in[i] - out[i]) > tolerance) return false;
+    }
+    return true;
+}
+
+//! Interleave numbered bytes and check the position of every byte
+static bool testInterleave(const size_t numChans, const size_t elemSize)
+{
+    const size_t numElems = 103;
+    std::vector<std::vector<unsigned char>> in(numChans, std::vector<unsigned char>(numElems*elemSize));
+    std::vector<const void *> ptrs;
+    for (size_t ch = 0; ch < numChans; ch++)
+    {
+        for (size_t i = 0; i < in[ch].size(); i++) in[ch][i] = (unsigned char)(i*numChans + ch);
+        ptrs.push_back(in[ch].data());
+    }
+
+    std::vector<unsigned char> out(numChans*numElems*elemSize);
+    interleaveChannels(reinterpret_cast<const void * const *>(ptrs.data()), numChans, out.data(), numElems, elemSize);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        for (size_t ch = 0; ch < numChans; ch++)
+        {
+            for (size_t b = 0; b < elemSize; b++)
+            {
+                if (out[(i*numChans + ch)*elemSize + b] != in[ch][i*elemSize + b]) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    std::cout << "test isConvertibleFormat()..." << std::endl;
+    if (not isConvertibleFormat(SOAPY_SDR_CS12)) return EXIT_FAILURE;
+    if (isConvertibleFormat(SOAPY_SDR_CU8)) return EXIT_FAILURE;
+
+    std::cout << "test SoapyMultiConverter round trips..." << std::endl;
+    if (not testRoundTrip(SOAPY_SDR_CS8, 128, 1.0/100)) return EXIT_FAILURE;
+    if (not testRoundTrip(SOAPY_SDR_CS12, 2048, 1.0/2000)) return EXIT_FAILURE;
+    if (not testRoundTrip(SOAPY_SDR_CS16, 32768, 1.0/30000)) return EXIT_FAILURE;
+    if (not testRoundTrip(SOAPY_SDR_CS16, 2048, 1.0/2000)) return EXIT_FAILURE;
+    if (not testRoundTrip(SOAPY_SDR_CF64, 1.0, 1e-6)) return EXIT_FAILURE;
+
+    std::cout << "test SoapyMultiConverter full-scale..." << std::endl;
+    const std::vector<int16_t> cs16 = {2048, -2048, 1024, 0};
+    std::vector<int8_t> cs8(cs16.size());
+    SoapyMultiConverter(SOAPY_SDR_CS16, 2048, SOAPY_SDR_CS8, 128).convert(cs16.data(), cs8.data(), cs16.size()/2);
+    if (cs8 != std::vector<int8_t>({127, -128, 64, 0})) return EXIT_FAILURE;
+
+    std::cout << "test interleaveChannels()..." << std::endl;
+    for (const size_t numChans : {1, 2, 3, 4, 5})
+    {
+        for (const size_t elemSize : {2, 3, 4, 8, 16})
+        {
+            if (not testInterleave(numChans, elemSize)) return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
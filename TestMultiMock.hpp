@@ -0,0 +1,25 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Fixtures of the tests which run the wrapper on mock devices.
+ * The tests are built with add_multi_test(), which links in
+ * the wrapper sources and the mock driver.
+ **********************************************************************/
+
+#pragma once
+#include "SoapyMultiSDR.hpp"
+#include <string>
+#include <vector>
+
+//! Make a wrapper with one mock device per args markup
+static inline SoapyMultiSDR *makeMock(const std::vector<std::string> &markups, const SoapySDR::Kwargs &options = SoapySDR::Kwargs())
+{
+    std::vector<SoapySDR::Kwargs> args;
+    for (const auto &markup : markups)
+    {
+        args.push_back(SoapySDR::KwargsFromString(markup));
+        args.back()["driver"] = "multimock";
+    }
+    return new SoapyMultiSDR(args, options);
+}
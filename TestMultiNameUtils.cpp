@@ -37,5 +37,28 @@ int main(void)
     std::cout << "test csvJoin()..." << std::endl;
     if (csvJoin(split) != "foo1, bar2, baz3") return EXIT_FAILURE;
 
+    std::cout << "test splitIndexedNames()..." << std::endl;
+    std::vector<size_t> indexes;
+    if (splitIndexedNames("test[*]", 3, indexes) != "test") return EXIT_FAILURE;
+    if (indexes != std::vector<size_t>({0, 1, 2})) return EXIT_FAILURE;
+    if (splitIndexedNames("test[2, 0]", 3, indexes) != "test") return EXIT_FAILURE;
+    if (indexes != std::vector<size_t>({2, 0})) return EXIT_FAILURE;
+    if (splitIndexedNames("test[1]", 3, indexes) != "test") return EXIT_FAILURE;
+    if (indexes != std::vector<size_t>({1})) return EXIT_FAILURE;
+    for (const auto &bad : {"test", "test[]", "test[3]", "test[0,0]", "test[0,x]", "test[0,,1]"})
+    {
+        try
+        {
+            splitIndexedNames(bad, 3, indexes); //should throw
+            return EXIT_FAILURE;
+        }
+        catch (const std::exception &ex){}
+    }
+
+    std::cout << "test jsonQuote()..." << std::endl;
+    if (jsonQuote("lock") != "\"lock\"") return EXIT_FAILURE;
+    if (jsonQuote("a\"b\\c\nd") != "\"a\\\"b\\\\c\\nd\"") return EXIT_FAILURE;
+    if (jsonQuote(std::string(1, '\x01')) != "\"\\u0001\"") return EXIT_FAILURE;
+
     return EXIT_SUCCESS;
 }
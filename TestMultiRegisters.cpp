@@ -0,0 +1,77 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the register access on several devices with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+static int testRegisters(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "", "", ""}));
+
+    //one device at a time, including the bulk read of a single device
+    device->writeRegister("regs[1]", 10, 1);
+    if (device->readRegister("regs[1]", 10) != 1) return EXIT_FAILURE;
+    if (device->readRegisters("regs[1]", 10, 2) != std::vector<unsigned>({1, 0})) return EXIT_FAILURE;
+
+    device->writeRegisters("regs[*]", 100, {7, 8, 9});
+
+    //reads from several devices return one block per device in the order of the list
+    device->writeRegister("regs[3,0]", 101, 5);
+    device->writeRegister("regs[2]", 102, 6);
+    const std::vector<unsigned> expected({7, 8, 6, 7, 5, 9, 7, 5, 9});
+    if (device->readRegisters("regs[2,3,0]", 100, 3) != expected) return EXIT_FAILURE;
+
+    //a single value can only be read from one device
+    try
+    {
+        device->readRegister("regs[*]", 100); //should throw
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &ex){}
+
+    //the un-named write and read stay on the first device, a broadcast is asked for by name
+    device->writeRegister(200, 3);
+    if (device->readRegisters("regs[*]", 200, 1) != std::vector<unsigned>({3, 0, 0, 0})) return EXIT_FAILURE;
+    if (device->readRegister(200) != 3) return EXIT_FAILURE;
+    device->writeRegister("regs[*]", 200, 4);
+    if (device->readRegisters("regs[*]", 200, 1) != std::vector<unsigned>({4, 4, 4, 4})) return EXIT_FAILURE;
+    if (device->readRegister(200) != 4) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+static int testBroadcast(void)
+{
+    //a serial broadcast waits for every device in turn, 10 times as long as one write
+    const std::vector<std::string> markups(10, "register_us=50000");
+    std::unique_ptr<SoapyMultiSDR> device(makeMock(markups));
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    device->writeRegisters("regs[*]", 100, {7, 8, 9});
+    const auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
+    if (elapsed >= std::chrono::milliseconds(50*markups.size()))
+    {
+        std::cerr << "broadcast took " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (device->readRegisters("regs[9]", 100, 3) != std::vector<unsigned>({7, 8, 9})) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+    std::cout << "test register access on several devices..." << std::endl;
+    if (testRegisters() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test register broadcast..." << std::endl;
+    if (testBroadcast() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the discovery of multi devices with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <cstdlib>
+
+//! Count the truncation warnings of the discovery
+static size_t numTruncated = 0;
+static void countTruncated(const SoapySDRLogLevel logLevel, const char *message)
+{
+    if (logLevel == SOAPY_SDR_WARNING and std::string(message).find("device combinations") != std::string::npos) numTruncated++;
+}
+
+//! Args which find findCount mock devices at each of the numIndexes indexes
+static SoapySDR::Kwargs findArgs(const size_t numIndexes, const size_t findCount)
+{
+    SoapySDR::Kwargs args;
+    args["driver"] = "multi";
+    for (size_t i = 0; i < numIndexes; i++)
+    {
+        args[toIndexedName("driver", i)] = "multimock";
+        args[toIndexedName("find_count", i)] = std::to_string(findCount);
+    }
+    return args;
+}
+
+//! Every assignment of distinct devices to the indexes is found, the first devices first
+static int testCombinations(void)
+{
+    const auto results = SoapySDR::Device::enumerate(findArgs(2, 3));
+    if (results.size() != 6) return EXIT_FAILURE;
+    for (const auto &result : results)
+    {
+        if (result.at("serial[0]") == result.at("serial[1]")) return EXIT_FAILURE;
+    }
+    if (results.front().at("serial[0]") != "0" or results.front().at("serial[1]") != "1") return EXIT_FAILURE;
+
+    //a result makes the multi device
+    auto device = SoapySDR::Device::make(results.front());
+    const size_t numChannels = device->getNumChannels(SOAPY_SDR_RX);
+    SoapySDR::Device::unmake(device);
+    return (numChannels == 2)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+//! Too many combinations are cut off at the limit with a warning
+static int testTruncated(void)
+{
+    numTruncated = 0;
+    SoapySDR::registerLogHandler(&countTruncated);
+    const auto few = SoapySDR::Device::enumerate(findArgs(3, 4));
+    const size_t numTruncatedFew = numTruncated;
+    const auto many = SoapySDR::Device::enumerate(findArgs(5, 5));
+    SoapySDR::registerLogHandler(nullptr);
+
+    //4*3*2 combinations are all returned, 5*4*3*2*1 are not
+    if (few.size() != 24 or numTruncatedFew != 0) return EXIT_FAILURE;
+    if (many.size() != 64 or numTruncated != 1) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+//! The discovery call of the mock device at index 0 which found the first result
+static std::string findCall(const SoapySDR::Kwargs &args)
+{
+    const auto results = SoapySDR::Device::enumerate(args);
+    return results.empty()?"":results.front().at("num_finds[0]");
+}
+
+//! Args with a cache entry of their own: the cache is shared by the process,
+//! and the two indexes differ so that they do not share an entry either
+static SoapySDR::Kwargs enumCacheArgs(const std::string &name, const std::string &ttlMs)
+{
+    auto args = findArgs(2, 2);
+    args["find_count[1]"] = "3";
+    args["case"] = name;
+    if (not ttlMs.empty()) args["multi:enum_cache_ms"] = ttlMs;
+    return args;
+}
+
+//! Discovery results are reused until the TTL, keyed by the args of each index
+static int testEnumCache(void)
+{
+    auto args = enumCacheArgs("ttl", "60000");
+    const auto first = findCall(args);
+    if (first.empty() or findCall(args) != first) return EXIT_FAILURE;
+
+    //the wrapper options are not part of the key
+    args["multi:enum_cache_ms"] = "30000";
+    if (findCall(args) != first) return EXIT_FAILURE;
+
+    //other args of the index are
+    args["find_count[0]"] = "4";
+    if (findCall(args) == first) return EXIT_FAILURE;
+
+    //expired results are enumerated again
+    args = enumCacheArgs("expiry", "1");
+    const auto expired = findCall(args);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (findCall(args) == expired) return EXIT_FAILURE;
+
+    //without a TTL nothing is cached
+    args = enumCacheArgs("uncached", "");
+    const auto uncached = findCall(args);
+    if (findCall(args) == uncached) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+    std::cout << "test findMultiSDR() combinations..." << std::endl;
+    if (testCombinations() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test findMultiSDR() truncated combinations..." << std::endl;
+    if (testTruncated() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test findMultiSDR() enumeration cache..." << std::endl;
+    if (testEnumCache() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "MultiRingUtils.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//! Fill the queue to capacity and drain it several times so the indexes wrap the storage
+static bool testQueue(void)
+{
+    SoapyMultiQueue<int> queue(3);
+    if (not queue.empty()) return false;
+    int next = 0, expected = 0;
+    for (size_t round = 0; round < 5; round++)
+    {
+        while (queue.push(next)) next++;
+        if (next != int(3*(round+1))) return false; //a full queue refuses the push
+        while (not queue.empty())
+        {
+            if (queue.front() != expected++) return false;
+            queue.pop();
+        }
+    }
+
+    queue.push(42);
+    queue.clear();
+    return queue.empty();
+}
+
+//! Write and read uneven blocks on three channels so the ring wraps between and inside blocks
+static bool testRingWrap(void)
+{
+    SoapyMultiRing ring(3, sizeof(uint32_t), 10);
+    uint32_t written = 0, read = 0;
+    for (const size_t numElems : {7, 6, 10, 3, 9, 1, 10, 4})
+    {
+        //the free space stops at the end of the storage, the rest is at the front
+        size_t numWritten = 0;
+        while (numWritten < numElems)
+        {
+            void *buffs[3];
+            const size_t numFree = ring.writeBuffs(buffs);
+            if (numFree == 0) return false;
+            const size_t n = std::min(numFree, numElems-numWritten);
+            for (size_t ch = 0; ch < 3; ch++)
+            {
+                for (size_t j = 0; j < n; j++) static_cast<uint32_t *>(buffs[ch])[j] = (written+uint32_t(j))*3 + uint32_t(ch);
+            }
+            ring.commit(n);
+            written += uint32_t(n);
+            numWritten += n;
+        }
+        if (ring.readable() != numElems or ring.writeIndex() != written) return false;
+
+        //a full ring has no free space
+        void *buffs[3];
+        if (numElems == ring.capacity() and ring.writeBuffs(buffs) != 0) return false;
+
+        //a read across the end of the storage continues at the front
+        std::vector<std::vector<uint32_t>> outs(3, std::vector<uint32_t>(numElems));
+        void *ptrs[] = {outs[0].data(), outs[1].data(), outs[2].data()};
+        ring.read(ptrs, numElems);
+        for (size_t ch = 0; ch < 3; ch++)
+        {
+            for (size_t j = 0; j < numElems; j++)
+            {
+                if (outs[ch][j] != (read+uint32_t(j))*3 + uint32_t(ch)) return false;
+            }
+        }
+        read += uint32_t(numElems);
+        if (ring.readable() != 0 or ring.readIndex() != read) return false;
+    }
+
+    ring.reset();
+    return ring.readIndex() == 0 and ring.writeIndex() == 0;
+}
+
+//! A producer and a consumer thread pass a counter through a small ring without losing an element
+static bool testRingThreads(void)
+{
+    const uint32_t numTotal = 1000000;
+    SoapyMultiRing ring(1, sizeof(uint32_t), 64);
+    std::thread producer([&ring, numTotal](void)
+    {
+        uint32_t next = 0;
+        while (next < numTotal)
+        {
+            void *buff;
+            const size_t n = std::min<size_t>(ring.writeBuffs(&buff), numTotal-next);
+            for (size_t j = 0; j < n; j++) static_cast<uint32_t *>(buff)[j] = next++;
+            if (n != 0) ring.commit(n);
+            else std::this_thread::yield();
+        }
+    });
+
+    bool ok = true;
+    uint32_t expected = 0;
+    std::vector<uint32_t> out(48);
+    while (expected < numTotal)
+    {
+        void *buff = out.data();
+        const size_t n = std::min(ring.readable(), out.size());
+        if (n == 0) std::this_thread::yield();
+        ring.read(&buff, n);
+        for (size_t j = 0; j < n; j++) if (out[j] != expected++) ok = false;
+    }
+    producer.join();
+    return ok;
+}
+
+int main(void)
+{
+    std::cout << "test SoapyMultiQueue wrap-around..." << std::endl;
+    if (not testQueue()) return EXIT_FAILURE;
+
+    std::cout << "test SoapyMultiRing wrap-around..." << std::endl;
+    if (not testRingWrap()) return EXIT_FAILURE;
+
+    std::cout << "test SoapyMultiRing producer and consumer threads..." << std::endl;
+    if (not testRingThreads()) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the sensor snapshot and the sensor poller with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+//! All the "time_us" values of the JSON in order of appearance
+static std::vector<long long> timesUs(const std::string &json)
+{
+    std::vector<long long> times;
+    const std::string key("\"time_us\": ");
+    for (auto pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos+1))
+    {
+        times.push_back(std::stoll(json.substr(pos+key.size())));
+    }
+    return times;
+}
+
+//! True when the JSON contains the text
+static bool contains(const std::string &json, const std::string &text)
+{
+    if (json.find(text) != std::string::npos) return true;
+    std::cerr << "missing " << text << " in " << json << std::endl;
+    return false;
+}
+
+static int testSnapshot(void)
+{
+    //every device takes 11 reads of 20ms: 7 global and 2 channels in each direction
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2,sensor_us=20000", "channels=1,sensor_us=20000", "channels=2,sensor_us=20000"}));
+    const auto json = device->readSensor(SOAPY_MULTI_SENSOR_SNAPSHOT);
+
+    //per-channel sensors appear under the global channel numbers of each device
+    if (not contains(json, "{\"device\": 0, \"sensors\": {\"num_acquired\": \"0\", \"num_active\": \"0\", \"num_sensor_reads\": \"3\", \"num_tx_elems\": \"0\", \"num_tx_ramp\": \"0\", \"num_instances\": \"3\", \"num_queries\": \"0\"}")) return EXIT_FAILURE;
+    if (not contains(json, "\"rx\": {\"0\": {\"lo_locked\": \"true\"}, \"1\": {\"lo_locked\": \"true\"}}")) return EXIT_FAILURE;
+    if (not contains(json, "{\"device\": 1, ")) return EXIT_FAILURE;
+    if (not contains(json, "\"tx\": {\"2\": {\"lo_locked\": \"true\"}}")) return EXIT_FAILURE;
+    if (not contains(json, "\"tx\": {\"3\": {\"lo_locked\": \"true\"}, \"4\": {\"lo_locked\": \"true\"}}")) return EXIT_FAILURE;
+    if (not contains(json, "\"errors\": {}, \"time_us\": ")) return EXIT_FAILURE;
+
+    //the devices were read concurrently: a serial snapshot takes at least as long as all the devices together
+    const auto times = timesUs(json);
+    if (times.size() != 4) return EXIT_FAILURE;
+    if (times[0] >= times[1] + times[2] + times[3])
+    {
+        std::cerr << "snapshot took " << times[0] << "us for devices of " << times[1] << "us, " << times[2] << "us, " << times[3] << "us" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //the snapshot is not one of the listed sensors
+    for (const auto &name : device->listSensors())
+    {
+        if (name == SOAPY_MULTI_SENSOR_SNAPSHOT) return EXIT_FAILURE;
+    }
+    if (device->getSensorInfo(SOAPY_MULTI_SENSOR_SNAPSHOT).type != SoapySDR::ArgInfo::STRING) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+static int testPoller(void)
+{
+    //only the first round is read before the poller is stopped
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2", "channels=2"}));
+    const auto ages = toIndexedName(SOAPY_MULTI_SENSOR_AGE, 1);
+    device->writeSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL, 1), "num_sensor_reads, rx1:lo_locked");
+    device->writeSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL_MS, 1), "600000");
+    if (device->readSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL_MS, 1)) != "600000") return EXIT_FAILURE;
+    if (device->readSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL, 1)) != "num_sensor_reads, rx1:lo_locked") return EXIT_FAILURE;
+
+    //wait for the first round of reads
+    for (size_t i = 0; i < 1000 and device->readSensor(ages).find("rx1:lo_locked") == std::string::npos; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (not contains(device->readSensor(ages), "{\"num_sensor_reads\": ")) return EXIT_FAILURE;
+
+    //polled sensors are served from the first round without reading the device again
+    for (size_t i = 0; i < 10; i++)
+    {
+        if (device->readSensor("num_sensor_reads[1]") != "1") return EXIT_FAILURE;
+        if (device->readSensor(SOAPY_SDR_RX, 3, "lo_locked") != "true") return EXIT_FAILURE;
+    }
+
+    //sensors which are not polled still read the device
+    if (device->readSensor(SOAPY_SDR_RX, 2, "lo_locked") != "true") return EXIT_FAILURE;
+    if (device->readSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL_MS, 0)) != "0") return EXIT_FAILURE;
+
+    //stopping forgets the values: the device saw the 2 polled reads, the read of rx2 and this read
+    device->writeSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL_MS, 1), "0");
+    const auto numReads = device->readSensor("num_sensor_reads[1]");
+    if (numReads != "4")
+    {
+        std::cerr << "expected 4 sensor reads, got " << numReads << std::endl;
+        return EXIT_FAILURE;
+    }
+    for (const auto &name : device->listSensors())
+    {
+        if (name == ages) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int testPollerOption(void)
+{
+    //every global sensor of every device is polled
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", ""}, {{"sensor_poll_ms", "1000"}}));
+    const auto sensors = device->listSensors();
+    for (const size_t i : {0, 1})
+    {
+        if (std::find(sensors.begin(), sensors.end(), toIndexedName(SOAPY_MULTI_SENSOR_AGE, i)) == sensors.end()) return EXIT_FAILURE;
+        if (device->readSetting(toIndexedName(SOAPY_MULTI_SENSOR_POLL, i)) != "num_acquired, num_active, num_sensor_reads, num_tx_elems, num_tx_ramp, num_instances, num_queries") return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+    std::cout << "test readSensor() snapshot..." << std::endl;
+    if (testSnapshot() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test sensor poller..." << std::endl;
+    if (testPoller() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test sensor poller option..." << std::endl;
+    if (testPollerOption() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
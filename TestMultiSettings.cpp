@@ -0,0 +1,265 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the device-level settings of the wrapper with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdlib>
+
+//! A device which fails to make closes the devices which did open
+static int testFailedMake(void)
+{
+    try
+    {
+        //one thread makes the devices in order, so the first two are open when the third fails
+        std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "", "make_error=true", ""}, {{"make_threads", "1"}}));
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &ex)
+    {
+        if (std::string(ex.what()).find("make_error") == std::string::npos) return EXIT_FAILURE;
+    }
+
+    //only the device of this wrapper is left open
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({""}));
+    const auto numInstances = device->readSensor("num_instances[0]");
+    if (numInstances == "1") return EXIT_SUCCESS;
+    std::cerr << numInstances << " mock devices are open" << std::endl;
+    return EXIT_FAILURE;
+}
+
+//! Broadcast setters reach every device, and an error on one device does not stop the others
+static int testFanOut(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "", ""}));
+    device->setClockSource("external, internal, external");
+    if (device->getClockSource() != "external, internal, external") return EXIT_FAILURE;
+    device->setTimeSource("internal, external, external");
+    if (device->getTimeSource() != "internal, external, external") return EXIT_FAILURE;
+
+    try
+    {
+        device->setClockSource("internal, bogus, internal"); //should throw
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &ex)
+    {
+        if (std::string(ex.what()).find("bogus") == std::string::npos) return EXIT_FAILURE;
+    }
+    if (device->getClockSource() != "internal, internal, internal") return EXIT_FAILURE;
+
+    //every device is set to the same time, give or take the time this test takes
+    const long long timeNs = 1000000000000000LL;
+    device->setHardwareTime(timeNs, "");
+    for (size_t i = 0; i < 3; i++)
+    {
+        const auto deviceTimeNs = std::stoll(device->readSetting(toIndexedName("hardware_time", i)));
+        if (deviceTimeNs < timeNs or deviceTimeNs > timeNs + 10000000000LL) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+//! The queries which reached the mock device
+static long numQueries(const SoapyMultiSDR &device, const size_t index)
+{
+    return std::stol(device.readSensor(toIndexedName("num_queries", index)));
+}
+
+//! The device queries of two range reads on the channel
+static long rangeQueries(SoapyMultiSDR &device, const size_t channel, const size_t index)
+{
+    const auto before = numQueries(device, index);
+    device.getFrequencyRange(SOAPY_SDR_RX, channel);
+    device.getFrequencyRange(SOAPY_SDR_RX, channel);
+    return numQueries(device, index) - before;
+}
+
+//! Range queries are served from the cache until the master clock rate
+//! or a setting, antenna or sample rate of their device changes
+static int testRangeCache(const bool cacheRanges)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "channels=2"}, {{"cache_ranges", cacheRanges?"true":"false"}}));
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (device->getFrequencyRange(SOAPY_SDR_RX, 1).size() != 1) return EXIT_FAILURE;
+        device->getFrequencyRange(SOAPY_SDR_RX, 2);
+        device->getSampleRateRange(SOAPY_SDR_RX, 1);
+    }
+    if (numQueries(*device, 0) != 0) return EXIT_FAILURE;
+    if (numQueries(*device, 1) != (cacheRanges?3:9)) return EXIT_FAILURE;
+
+    //the ranges usually depend on the master clock
+    device->setMasterClockRate(40e6);
+    device->getFrequencyRange(SOAPY_SDR_RX, 1);
+    device->getFrequencyRange(SOAPY_SDR_RX, 1);
+    if (numQueries(*device, 1) != (cacheRanges?4:11)) return EXIT_FAILURE;
+
+    //the ranges of the other device stay cached
+    const std::vector<std::function<void(void)>> changes = {
+        [&](void){device->writeSetting("anything[1]", "1");},
+        [&](void){device->writeSetting(SOAPY_SDR_RX, 2, "anything", "1");},
+        [&](void){device->setAntenna(SOAPY_SDR_RX, 1, "RX");},
+        [&](void){device->setSampleRate(SOAPY_SDR_RX, 2, 2e6);},
+    };
+    device->getFrequencyRange(SOAPY_SDR_RX, 0);
+    for (const auto &change : changes)
+    {
+        change();
+        if (rangeQueries(*device, 1, 1) != (cacheRanges?1:2)) return EXIT_FAILURE;
+        if (rangeQueries(*device, 0, 0) != (cacheRanges?0:2)) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+//! Getters are served from the cache until a related set call on the device,
+//! and a set call caches the value which the device reports after it
+static int testGetterCache(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2", "channels=2"}));
+    device->setFrequency(SOAPY_SDR_RX, 0, 1e9, SoapySDR::Kwargs());
+    if (numQueries(*device, 0) != 1) return EXIT_FAILURE;
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (device->getFrequency(SOAPY_SDR_RX, 0) != 1e9) return EXIT_FAILURE;
+        if (device->getFrequency(SOAPY_SDR_RX, 1) != 0.0) return EXIT_FAILURE;
+        if (device->getFrequency(SOAPY_SDR_RX, 2) != 0.0) return EXIT_FAILURE;
+        if (device->getSampleRate(SOAPY_SDR_RX, 1) != 1e6) return EXIT_FAILURE;
+    }
+    if (numQueries(*device, 0) != 3 or numQueries(*device, 1) != 1) return EXIT_FAILURE;
+
+    //the mock shares the rate between its channels, so a set on one channel changes the other
+    device->setSampleRate(SOAPY_SDR_RX, 0, 2e6);
+    if (device->getSampleRate(SOAPY_SDR_RX, 0) != 2e6) return EXIT_FAILURE;
+    if (device->getSampleRate(SOAPY_SDR_RX, 1) != 2e6) return EXIT_FAILURE;
+    if (numQueries(*device, 0) != 5) return EXIT_FAILURE;
+
+    //a tune may move a shared LO, the frequencies of the other device stay cached
+    device->setFrequency(SOAPY_SDR_RX, 0, 2e9, SoapySDR::Kwargs());
+    if (device->getFrequency(SOAPY_SDR_RX, 0) != 2e9) return EXIT_FAILURE;
+    device->getFrequency(SOAPY_SDR_RX, 1);
+    device->getFrequency(SOAPY_SDR_RX, 2);
+    if (numQueries(*device, 0) != 7 or numQueries(*device, 1) != 1) return EXIT_FAILURE;
+
+    //an untimed batched tune caches the new frequencies as well
+    device->setFrequencies({{SOAPY_SDR_RX, 1, 3e9, {}}, {SOAPY_SDR_RX, 3, 4e9, {}}});
+    if (numQueries(*device, 0) != 8 or numQueries(*device, 1) != 2) return EXIT_FAILURE;
+    if (device->getFrequency(SOAPY_SDR_RX, 1) != 3e9 or device->getFrequency(SOAPY_SDR_RX, 3) != 4e9) return EXIT_FAILURE;
+    if (numQueries(*device, 0) != 8 or numQueries(*device, 1) != 2) return EXIT_FAILURE;
+
+    //a device setting may change anything on that device
+    device->writeSetting("anything[1]", "1");
+    device->getFrequency(SOAPY_SDR_RX, 2);
+    device->getFrequency(SOAPY_SDR_RX, 2);
+    if (numQueries(*device, 1) != 3) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+//! Without the getter cache every get reads the device
+static int testNoGetterCache(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({""}, {{"cache_getters", "false"}}));
+    device->setFrequency(SOAPY_SDR_RX, 0, 1e9, SoapySDR::Kwargs());
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (device->getFrequency(SOAPY_SDR_RX, 0) != 1e9) return EXIT_FAILURE;
+    }
+    return (numQueries(*device, 0) == 3)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+//! A batched tune sets every channel at the command time and clears the command time afterwards
+static int testBatchedTune(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2", "channels=2"}));
+    device->writeSetting("TUNE", "rx0=1e9, rx3=2e9, tx1=3e9, time=5000");
+    if (device->getFrequency(SOAPY_SDR_RX, 0) != 1e9) return EXIT_FAILURE;
+    if (device->getFrequency(SOAPY_SDR_RX, 3) != 2e9) return EXIT_FAILURE;
+    if (device->getFrequency(SOAPY_SDR_TX, 1) != 3e9) return EXIT_FAILURE;
+    if (device->readSetting(SOAPY_SDR_RX, 0, "tune_time") != "5000") return EXIT_FAILURE;
+    if (device->readSetting(SOAPY_SDR_RX, 3, "tune_time") != "5000") return EXIT_FAILURE;
+    if (device->readSetting(SOAPY_SDR_TX, 1, "tune_time") != "5000") return EXIT_FAILURE;
+    if (device->readSetting("command_time[0]") != "0" or device->readSetting("command_time[1]") != "0") return EXIT_FAILURE;
+
+    //without a time the channels tune right away, the cached frequencies are replaced
+    device->setFrequencies({{SOAPY_SDR_RX, 0, 4e8, {}}, {SOAPY_SDR_RX, 2, 5e8, {}}});
+    if (device->getFrequency(SOAPY_SDR_RX, 0) != 4e8) return EXIT_FAILURE;
+    if (device->getFrequency(SOAPY_SDR_RX, 2) != 5e8) return EXIT_FAILURE;
+    if (device->readSetting(SOAPY_SDR_RX, 2, "tune_time") != "0") return EXIT_FAILURE;
+
+    try
+    {
+        device->writeSetting("TUNE", "bogus0=1e9"); //should throw
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &ex){}
+    return EXIT_SUCCESS;
+}
+
+//! A frequency read before the command time of a timed tune is not cached
+static int testTimedTune(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2,timed_tune=true", "timed_tune=true"}));
+    device->setHardwareTime(0, "");
+    device->getFrequency(SOAPY_SDR_RX, 0);
+
+    //the devices keep the old frequencies until the command time,
+    //unless this test was so slow that the command time already passed
+    const long long delayNs = 300000000;
+    device->writeSetting("TUNE", "rx0=1e9, rx2=2e9, time=" + std::to_string(delayNs));
+    for (const size_t channel : {0, 2})
+    {
+        const auto frequency = device->getFrequency(SOAPY_SDR_RX, channel);
+        if (device->getHardwareTime("") < delayNs and frequency != 0.0) return EXIT_FAILURE;
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(delayNs));
+    if (device->getFrequency(SOAPY_SDR_RX, 0) != 1e9) return EXIT_FAILURE;
+    if (device->getFrequency(SOAPY_SDR_RX, 2) != 2e9) return EXIT_FAILURE;
+
+    //once the command time passed the values are cached again
+    const auto numCached = numQueries(*device, 0);
+    device->getFrequency(SOAPY_SDR_RX, 0);
+    if (numQueries(*device, 0) != numCached) return EXIT_FAILURE;
+
+    //the same for a set call between setCommandTime() calls
+    const long long timeNs = device->getHardwareTime("") + delayNs;
+    device->setCommandTime(timeNs, "");
+    device->setFrequency(SOAPY_SDR_RX, 1, 3e9, SoapySDR::Kwargs());
+    device->setCommandTime(0, "");
+    const auto frequency = device->getFrequency(SOAPY_SDR_RX, 1);
+    if (device->getHardwareTime("") < timeNs and frequency != 0.0) return EXIT_FAILURE;
+    std::this_thread::sleep_for(std::chrono::nanoseconds(delayNs));
+    if (device->getFrequency(SOAPY_SDR_RX, 1) != 3e9) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+    std::cout << "test failed make..." << std::endl;
+    if (testFailedMake() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test broadcast setters..." << std::endl;
+    if (testFanOut() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test range cache..." << std::endl;
+    if (testRangeCache(true) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testRangeCache(false) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test getter cache..." << std::endl;
+    if (testGetterCache() != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testNoGetterCache() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test batched tune..." << std::endl;
+    if (testBatchedTune() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test timed tune..." << std::endl;
+    if (testTimedTune() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
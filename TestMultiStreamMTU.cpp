@@ -0,0 +1,95 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the aggregated MTU and the transfers in whole sub-device MTUs
+ * with mock devices of different MTUs.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Time.hpp>
+#include <iostream>
+#include <complex>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+
+static int testStreamMTU(const std::string &policy, const size_t expected)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"mtu=4096", "mtu=1536"}));
+    SoapySDR::Kwargs args;
+    args["multi:mtu"] = policy;
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    const size_t mtu = device->getStreamMTU(stream);
+    device->closeStream(stream);
+    return (mtu == expected)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+//! Reads under the larger MTU stay contiguous on every channel, with the timestamp of their first element
+static int testSmallReads(const bool coalesce)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"mtu=4096", "mtu=1536"}));
+    SoapySDR::Kwargs args;
+    if (coalesce) args["multi:coalesce"] = "true";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::complex<float>> buff0(1000), buff1(1000);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    int result = EXIT_SUCCESS;
+    long long ticks = 0;
+    for (size_t i = 0; i < 50 and result == EXIT_SUCCESS; i++)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device->readStream(stream, buffs, buff0.size(), flags, timeNs, 100000);
+        if (ret <= 0) result = EXIT_FAILURE;
+        if ((flags & SOAPY_SDR_HAS_TIME) == 0 or timeNs != SoapySDR::ticksToTimeNs(ticks, 1e6)) result = EXIT_FAILURE;
+        for (int j = 0; j < ret; j++)
+        {
+            const float expected = float((ticks+j) & 0x7fff);
+            if (buff0[j].real() != expected or buff1[j].real() != expected) result = EXIT_FAILURE;
+        }
+        ticks += ret;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! A write over every MTU is accepted in one call
+static int testChunkedWrite(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"mtu=512", "mtu=2048"}));
+    SoapySDR::Kwargs args;
+    args["multi:coalesce"] = "true";
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::complex<float>> buff(5000);
+    const void *buffs[] = {buff.data(), buff.data()};
+    int flags = 0;
+    const int ret = device->writeStream(stream, buffs, buff.size(), flags, 0, 100000);
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return (ret == int(buff.size()))?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+int main(void)
+{
+    std::cout << "test getStreamMTU() policies..." << std::endl;
+    if (testStreamMTU("min", 1536) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testStreamMTU("lcm", 12288) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() under the MTU..." << std::endl;
+    if (testSmallReads(false) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSmallReads(true) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test writeStream() over the MTU..." << std::endl;
+    if (testChunkedWrite() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
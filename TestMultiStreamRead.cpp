@@ -0,0 +1,395 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the merged readStream() with mock devices which return
+ * short reads and different timestamps.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Time.hpp>
+#include <SoapySDR/Logger.hpp>
+#include <iostream>
+#include <complex>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+//! Check that every channel holds the mock ramp from the tick on, scaled down by the full-scale, false otherwise
+static bool checkRamp(const std::vector<std::complex<float>> &buff, const size_t numElems, const long long ticks, const float fullScale = 1.0f)
+{
+    for (size_t j = 0; j < numElems; j++)
+    {
+        const float expected = float((ticks+j) & 0x7fff)/fullScale;
+        if (buff[j].real() == expected) continue;
+        std::cerr << "expected " << expected << " at tick " << ticks+j << ", got " << buff[j].real() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//! Uneven short reads on devices which are 37 ticks apart merge into one aligned and contiguous ramp
+static int testShortReads(const SoapySDR::Kwargs &args)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"short_reads=0.5", "short_reads=0.3,ticks=37", "channels=2,short_reads=0.7,ticks=5"}));
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1, 2, 3}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    //the early devices drop their leading elements up to the latest device
+    std::vector<std::vector<std::complex<float>>> buffs(4, std::vector<std::complex<float>>(300));
+    std::vector<void *> ptrs;
+    for (auto &buff : buffs) ptrs.push_back(buff.data());
+    int result = EXIT_SUCCESS;
+    long long ticks = 37;
+    for (size_t i = 0; i < 100 and result == EXIT_SUCCESS; i++)
+    {
+        //requests of different sizes move the surplus through the remainders
+        const size_t numElems = 50 + (i*37) % 250;
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device->readStream(stream, ptrs.data(), numElems, flags, timeNs, 100000);
+        if (ret == 0) continue;
+        if (ret < 0 or size_t(ret) > numElems) result = EXIT_FAILURE;
+        if ((flags & SOAPY_SDR_HAS_TIME) == 0 or timeNs != SoapySDR::ticksToTimeNs(ticks, 1e6))
+        {
+            std::cerr << "read " << i << " at " << timeNs << "ns, expected tick " << ticks << std::endl;
+            result = EXIT_FAILURE;
+        }
+        for (const auto &buff : buffs)
+        {
+            if (ret > 0 and not checkRamp(buff, size_t(ret), ticks)) result = EXIT_FAILURE;
+        }
+        if (ret > 0) ticks += ret;
+    }
+
+    //every device was dropped into line exactly once
+    if (ticks < 37 + 1000) result = EXIT_FAILURE;
+    const auto stats = device->readSensor(toIndexedName(SOAPY_MULTI_STREAM_STATS, 0));
+    if (stats.find("\"dropped\": 37") == std::string::npos or stats.find("\"dropped\": 32") == std::string::npos)
+    {
+        std::cerr << "unexpected drops in " << stats << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+/*!
+ * Read an interleaved stream from devices which are 37 ticks apart.
+ * The mock puts the ramp into the real part and the channel of its
+ * device into the imaginary part, so every element of the output
+ * is checked for its tick and for the slot of its channel.
+ */
+template <typename Type>
+static int testInterleaved(const std::string &format, const std::vector<std::string> &markups, const std::vector<size_t> &channels)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock(markups));
+    SoapySDR::Kwargs args;
+    args["multi:layout"] = "interleaved";
+    auto stream = device->setupStream(SOAPY_SDR_RX, format, channels, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    //the global channels map to the device channels in order, two per device
+    const size_t numChans = channels.size();
+    std::vector<Type> buff(2*numChans*300);
+    void *ptrs[] = {buff.data()};
+    int result = EXIT_SUCCESS;
+    long long ticks = 37;
+    for (size_t i = 0; i < 20 and result == EXIT_SUCCESS; i++)
+    {
+        const size_t numElems = 50 + (i*37) % 250;
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device->readStream(stream, ptrs, numElems, flags, timeNs, 100000);
+        if (ret == 0) continue;
+        if (ret < 0 or size_t(ret) > numElems) result = EXIT_FAILURE;
+        if ((flags & SOAPY_SDR_HAS_TIME) == 0 or timeNs != SoapySDR::ticksToTimeNs(ticks, 1e6)) result = EXIT_FAILURE;
+        for (size_t j = 0; j < size_t(std::max(ret, 0)) and result == EXIT_SUCCESS; j++)
+        {
+            for (size_t k = 0; k < numChans; k++)
+            {
+                const Type re = buff[2*(j*numChans+k)+0];
+                const Type im = buff[2*(j*numChans+k)+1];
+                if (re == Type((ticks+j) & 0x7fff) and im == Type(channels[k] % 2)) continue;
+                std::cerr << format << " element " << j << " of channel " << channels[k] << " is ("
+                    << re << ", " << im << ") at tick " << ticks+j << std::endl;
+                result = EXIT_FAILURE;
+            }
+        }
+        if (ret > 0) ticks += ret;
+    }
+    if (ticks < 37 + 1000) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! The native CS16 sub-streams of multi:native are converted into the CF32 ramp at the full-scale of the mock
+static int testNativeRead(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"short_reads=0.5", "short_reads=0.3,ticks=37"}));
+    SoapySDR::Kwargs args;
+    args["multi:native"] = "true";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    //the conversion buffers are not in the stream format, so there is no direct access
+    int result = EXIT_SUCCESS;
+    if (device->getNumDirectAccessBuffers(stream) != 0) result = EXIT_FAILURE;
+
+    std::vector<std::complex<float>> buff0(300), buff1(300);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    long long ticks = 37;
+    for (size_t i = 0; i < 50 and result == EXIT_SUCCESS; i++)
+    {
+        const size_t numElems = 50 + (i*37) % 250;
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device->readStream(stream, buffs, numElems, flags, timeNs, 100000);
+        if (ret == 0) continue;
+        if (ret < 0 or size_t(ret) > numElems) result = EXIT_FAILURE;
+        if ((flags & SOAPY_SDR_HAS_TIME) == 0 or timeNs != SoapySDR::ticksToTimeNs(ticks, 1e6)) result = EXIT_FAILURE;
+        for (const auto &buff : {&buff0, &buff1})
+        {
+            if (ret > 0 and not checkRamp(*buff, size_t(ret), ticks, 32768.0f)) result = EXIT_FAILURE;
+        }
+        if (ret > 0) ticks += ret;
+    }
+    if (ticks < 37 + 1000) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! Check that every buffer holds the mock ramp at the ticks of the timestamp, false otherwise
+static bool checkTimedRamp(const std::vector<std::vector<std::complex<float>>> &buffs, const int ret, const int flags, const long long timeNs)
+{
+    if ((flags & SOAPY_SDR_HAS_TIME) == 0) return false;
+    for (const auto &buff : buffs)
+    {
+        if (not checkRamp(buff, size_t(ret), SoapySDR::timeNsToTicks(timeNs, 1e6))) return false;
+    }
+    return true;
+}
+
+//! Background readers keep the ramp contiguous through the rings and report their overflows
+static int testBackgroundReader(void)
+{
+    //the latency paces the mock at about 1Msps, the 50ms rings fill up while the caller sleeps
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"mtu=1000,latency_us=1000", "mtu=1000,latency_us=1000,ticks=37"}));
+    SoapySDR::Kwargs args;
+    args["multi:buffer_ms"] = "50";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::vector<std::complex<float>>> buffs(2, std::vector<std::complex<float>>(700));
+    void *ptrs[] = {buffs[0].data(), buffs[1].data()};
+    int result = EXIT_SUCCESS;
+    int flags = 0;
+    long long timeNs = 0;
+
+    //the reads wrap the rings, and each one continues where the last one ended
+    long long nextTimeNs = SoapySDR::ticksToTimeNs(37, 1e6);
+    for (size_t i = 0; i < 50 and result == EXIT_SUCCESS; i++)
+    {
+        const int ret = device->readStream(stream, ptrs, 700, flags, timeNs, 1000000);
+        if (ret == 0) continue;
+        if (ret < 0 or timeNs != nextTimeNs or not checkTimedRamp(buffs, ret, flags, timeNs)) result = EXIT_FAILURE;
+        if (ret > 0) nextTimeNs = timeNs + SoapySDR::ticksToTimeNs(ret, 1e6);
+    }
+
+    //the overflow is reported after the elements which were read before it
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    int ret = 0;
+    for (size_t i = 0; i < 1000 and result == EXIT_SUCCESS; i++)
+    {
+        ret = device->readStream(stream, ptrs, 700, flags, timeNs, 1000000);
+        if (ret == SOAPY_SDR_OVERFLOW) break;
+        if (ret < 0 or (ret > 0 and not checkTimedRamp(buffs, ret, flags, timeNs))) result = EXIT_FAILURE;
+        if (ret > 0) nextTimeNs = timeNs + SoapySDR::ticksToTimeNs(ret, 1e6);
+    }
+    if (ret != SOAPY_SDR_OVERFLOW)
+    {
+        std::cerr << "expected an overflow, got " << ret << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    //the next segment starts past the dropped elements with the timestamp of its first element
+    bool resumed = false;
+    for (size_t i = 0; i < 50 and result == EXIT_SUCCESS; i++)
+    {
+        ret = device->readStream(stream, ptrs, 700, flags, timeNs, 1000000);
+        if (ret == SOAPY_SDR_OVERFLOW) continue; //of the other ring
+        if (ret < 0 or (ret > 0 and not checkTimedRamp(buffs, ret, flags, timeNs))) result = EXIT_FAILURE;
+        if (ret > 0 and not resumed and timeNs <= nextTimeNs) result = EXIT_FAILURE;
+        if (ret > 0) resumed = true;
+    }
+    if (not resumed) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! A background reader reports a device which keeps failing, and retries it without a busy loop
+static int testReaderError(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "read_error=" + std::to_string(SOAPY_SDR_STREAM_ERROR)}));
+    SoapySDR::Kwargs args;
+    args["multi:buffer_ms"] = "50";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::complex<float>> buff0(500), buff1(500);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    int flags = 0;
+    long long timeNs = 0;
+    const int ret = device->readStream(stream, buffs, buff0.size(), flags, timeNs, 1000000);
+
+    //the waits between the retries grow to the read timeout of 100ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const long numReads = std::stol(device->readSetting("num_stream_reads[1]"));
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    if (ret != SOAPY_SDR_STREAM_ERROR) return EXIT_FAILURE;
+    if (numReads <= 50) return EXIT_SUCCESS;
+    std::cerr << "the failing device was read " << numReads << " times" << std::endl;
+    return EXIT_FAILURE;
+}
+
+//! A counter of one sub-stream in the stream_stats JSON, -1 when it is missing
+static long long subStreamCounter(const std::string &json, const size_t deviceIndex, const std::string &name)
+{
+    const auto pos = json.find("{\"device\": " + std::to_string(deviceIndex) + ",");
+    if (pos == std::string::npos) return -1;
+    const auto key = json.find("\"" + name + "\": ", pos);
+    if (key == std::string::npos) return -1;
+    return std::stoll(json.substr(key + name.size() + 4));
+}
+
+//! Count the skew warnings of the wrapper
+static size_t numSkewWarnings = 0;
+static void countSkewWarnings(const SoapySDRLogLevel logLevel, const char *message)
+{
+    if (logLevel == SOAPY_SDR_WARNING and std::string(message).find("timestamps differ") != std::string::npos) numSkewWarnings++;
+}
+
+/*!
+ * Read from a device which starts 37 ticks after the other one,
+ * and check where the ramp of each channel starts, the zeros padded
+ * in front of the second channel, the counters and the warnings.
+ */
+static int testSkewPolicy(const std::string &policy, const std::string &thresholdUs,
+    const long long start0, const long long start1, const long long numDropped, const long long numPadded, const size_t numWarnings)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "ticks=37"}));
+    SoapySDR::Kwargs args;
+    args["multi:skew_policy"] = policy;
+    if (not thresholdUs.empty()) args["multi:skew_threshold_us"] = thresholdUs;
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    numSkewWarnings = 0;
+    SoapySDR::registerLogHandler(&countSkewWarnings);
+    std::vector<std::complex<float>> buff0(500), buff1(500);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    int result = EXIT_SUCCESS;
+    for (size_t i = 0; i < 3 and result == EXIT_SUCCESS; i++)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device->readStream(stream, buffs, buff0.size(), flags, timeNs, 100000);
+        if (ret <= 0 or i != 0) continue;
+        if (timeNs != SoapySDR::ticksToTimeNs(start0, 1e6)) result = EXIT_FAILURE;
+        if (not checkRamp(buff0, size_t(ret), start0)) result = EXIT_FAILURE;
+        for (size_t j = 0; j < size_t(ret); j++)
+        {
+            const float expected = (j < size_t(numPadded))?0.0f:float(start1 + j - numPadded);
+            if (buff1[j].real() != expected) result = EXIT_FAILURE;
+        }
+    }
+    SoapySDR::registerLogHandler(nullptr);
+
+    //the first read aligns the channels, the remainders keep them aligned
+    const auto stats = device->readSensor(toIndexedName(SOAPY_MULTI_STREAM_STATS, 0));
+    if (subStreamCounter(stats, 0, "dropped") != numDropped or subStreamCounter(stats, 1, "dropped") != 0 or
+        subStreamCounter(stats, 0, "padded") != 0 or subStreamCounter(stats, 1, "padded") != numPadded or
+        numSkewWarnings != numWarnings)
+    {
+        std::cerr << policy << " skew with " << numSkewWarnings << " warnings: " << stats << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! A skew over the threshold fails the read with the error policy
+static int testSkewError(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "ticks=37"}));
+    SoapySDR::Kwargs args;
+    args["multi:skew_policy"] = "error";
+    args["multi:skew_threshold_us"] = "10";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    std::vector<std::complex<float>> buff0(500), buff1(500);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    int flags = 0;
+    long long timeNs = 0;
+    const int ret = device->readStream(stream, buffs, buff0.size(), flags, timeNs, 100000);
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return (ret == SOAPY_SDR_TIME_ERROR)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+int main(void)
+{
+    std::cout << "test readStream() short reads..." << std::endl;
+    if (testShortReads(SoapySDR::Kwargs()) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() short reads in parallel..." << std::endl;
+    SoapySDR::Kwargs parallel;
+    parallel["multi:parallel"] = "true";
+    if (testShortReads(parallel) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() interleaved layout..." << std::endl;
+    const std::vector<std::string> skewed({"channels=2,short_reads=0.5", "channels=2,short_reads=0.3,ticks=37"});
+    if (testInterleaved<int16_t>(SOAPY_SDR_CS16, skewed, {1, 2}) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testInterleaved<float>(SOAPY_SDR_CF32, skewed, {1, 2}) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testInterleaved<int16_t>(SOAPY_SDR_CS16, skewed, {3, 0, 2, 1}) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testInterleaved<float>(SOAPY_SDR_CF32, skewed, {3, 0, 2, 1}) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() native conversion..." << std::endl;
+    if (testNativeRead() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() background readers..." << std::endl;
+    if (testBackgroundReader() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() background reader errors..." << std::endl;
+    if (testReaderError() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStream() skew policies..." << std::endl;
+    if (testSkewPolicy("drop", "", 37, 37, 37, 0, 0) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSkewPolicy("pad", "", 0, 37, 0, 37, 0) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSkewPolicy("warn", "", 0, 37, 0, 0, 1) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSkewPolicy("warn", "100", 0, 37, 0, 0, 0) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSkewPolicy("error", "100", 37, 37, 37, 0, 0) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testSkewError() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the coordinated activateStream() and deactivateStream() with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <iostream>
+#include <complex>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+
+//! Devices with different sample counts are only aligned after a coordinated start
+static int testCoordinatedStart(const bool coordinated)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"ticks=0", "ticks=100000"}));
+    SoapySDR::Kwargs args;
+    args["multi:skew_policy"] = "error";
+    args["multi:start_margin_ms"] = coordinated?"20":"0";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+
+    const long long startNs = device->getHardwareTime("");
+    int result = EXIT_SUCCESS;
+    if (device->activateStream(stream, 0, 0, 0) != 0) result = EXIT_FAILURE;
+
+    std::vector<std::complex<float>> buff0(1000), buff1(1000);
+    void *buffs[] = {buff0.data(), buff1.data()};
+    int flags = 0;
+    long long timeNs = 0;
+    const int ret = device->readStream(stream, buffs, buff0.size(), flags, timeNs, 1000000);
+    //the start time is rounded to a sample of the 1Msps mock
+    if (coordinated and (ret <= 0 or timeNs < startNs + 20000000 - 1000)) result = EXIT_FAILURE;
+    if (not coordinated and ret != SOAPY_SDR_TIME_ERROR) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! A device which fails to start leaves the other devices inactive
+static int testRollback(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "activate_ret=-2", ""}));
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1, 2}, SoapySDR::Kwargs());
+
+    int result = EXIT_SUCCESS;
+    if (device->activateStream(stream, 0, 0, 0) != -2) result = EXIT_FAILURE;
+    for (const auto &name : {"num_active[0]", "num_active[1]", "num_active[2]"})
+    {
+        if (device->readSensor(name) != "0") result = EXIT_FAILURE;
+    }
+
+    device->closeStream(stream);
+    return result;
+}
+
+//! The start margin does not make the stop timed, only the stop margin does
+static int testStop(const bool stopMargin)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"timed_stop=false", "timed_stop=false"}));
+    SoapySDR::Kwargs args;
+    args["multi:start_margin_ms"] = "20";
+    if (stopMargin) args["multi:stop_margin_ms"] = "20";
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, args);
+
+    int result = EXIT_SUCCESS;
+    if (device->activateStream(stream, 0, 0, 0) != 0) result = EXIT_FAILURE;
+    const int ret = device->deactivateStream(stream, 0, 0);
+    if (ret != (stopMargin?SOAPY_SDR_NOT_SUPPORTED:0)) result = EXIT_FAILURE;
+
+    device->closeStream(stream);
+    return result;
+}
+
+int main(void)
+{
+    std::cout << "test activateStream() uncoordinated..." << std::endl;
+    if (testCoordinatedStart(false) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test activateStream() coordinated..." << std::endl;
+    if (testCoordinatedStart(true) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test activateStream() rollback..." << std::endl;
+    if (testRollback() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test deactivateStream() untimed..." << std::endl;
+    if (testStop(false) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test deactivateStream() stop margin..." << std::endl;
+    if (testStop(true) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
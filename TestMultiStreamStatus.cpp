@@ -0,0 +1,161 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the concurrent readStreamStatus() with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <iostream>
+#include <chrono>
+#include <complex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+//! Write one burst on all channels and collect the masks of the burst acks
+static int testBurstAcks(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=2", "channels=1", "channels=2"}));
+    const std::vector<size_t> channels = {0, 1, 2, 3, 4};
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, channels, SoapySDR::Kwargs());
+    device->activateStream(stream, 0, 0, 0);
+
+    //nothing was sent yet
+    size_t chanMask = 0;
+    int flags = 0;
+    long long timeNs = 0;
+    int result = EXIT_SUCCESS;
+    if (device->readStreamStatus(stream, chanMask, flags, timeNs, 50000) != SOAPY_SDR_TIMEOUT) result = EXIT_FAILURE;
+
+    std::vector<std::complex<float>> buff(100);
+    std::vector<const void *> buffs(channels.size(), buff.data());
+    flags = SOAPY_SDR_END_BURST;
+    if (device->writeStream(stream, buffs.data(), buff.size(), flags, 0, 100000) != int(buff.size())) result = EXIT_FAILURE;
+
+    //one ack per device, each with the mask of its channels in the stream
+    size_t allMasks = 0;
+    for (size_t i = 0; i < 3; i++)
+    {
+        chanMask = 0;
+        if (device->readStreamStatus(stream, chanMask, flags, timeNs, 1000000) != 0) result = EXIT_FAILURE;
+        if ((flags & SOAPY_SDR_END_BURST) == 0) result = EXIT_FAILURE;
+        if (chanMask != 0x3 and chanMask != 0x4 and chanMask != 0x18) result = EXIT_FAILURE;
+        allMasks |= chanMask;
+    }
+    if (allMasks != 0x1f) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! The devices are waited on concurrently, so the timeout is waited out once
+static int testTimeoutOnce(void)
+{
+    //a serial wait takes at least 10 timeouts, one per device
+    const std::vector<std::string> markups(10, "channels=1");
+    std::unique_ptr<SoapyMultiSDR> device(makeMock(markups));
+    std::vector<size_t> channels;
+    for (size_t i = 0; i < markups.size(); i++) channels.push_back(i);
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, channels, SoapySDR::Kwargs());
+    device->activateStream(stream, 0, 0, 0);
+
+    size_t chanMask = 0;
+    int flags = 0;
+    long long timeNs = 0;
+    const long timeoutUs = 30000;
+    int result = EXIT_SUCCESS;
+    const auto start = std::chrono::steady_clock::now();
+    if (device->readStreamStatus(stream, chanMask, flags, timeNs, timeoutUs) != SOAPY_SDR_TIMEOUT) result = EXIT_FAILURE;
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed >= std::chrono::microseconds(timeoutUs*markups.size()))
+    {
+        std::cerr << "status wait took " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms" << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! The status calls of the device so far
+static std::string numStatusReads(const SoapyMultiSDR &device, const size_t index)
+{
+    return device.readSetting(toIndexedName("num_status_reads", index));
+}
+
+//! A device which keeps failing is polled with a growing wait, and no device is polled while the stream is inactive
+static int testStatusError(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "status_error=" + std::to_string(SOAPY_SDR_STREAM_ERROR)}));
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, {0, 1}, SoapySDR::Kwargs());
+    device->activateStream(stream, 0, 0, 0);
+
+    size_t chanMask = 0;
+    int flags = 0;
+    long long timeNs = 0;
+    int result = EXIT_SUCCESS;
+    if (device->readStreamStatus(stream, chanMask, flags, timeNs, 1000000) != SOAPY_SDR_STREAM_ERROR) result = EXIT_FAILURE;
+
+    //the waits between the polls grow to the poll timeout of 100ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const long numPolls = std::stol(numStatusReads(*device, 1));
+    if (numPolls > 50)
+    {
+        std::cerr << "the failing device was polled " << numPolls << " times" << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    //the events queued before the deactivation can still be read
+    device->deactivateStream(stream, 0, 0);
+    const auto numPolls0 = numStatusReads(*device, 0);
+    const auto numPolls1 = numStatusReads(*device, 1);
+    if (device->readStreamStatus(stream, chanMask, flags, timeNs, 1000) != SOAPY_SDR_STREAM_ERROR) result = EXIT_FAILURE;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    if (numStatusReads(*device, 0) != numPolls0 or numStatusReads(*device, 1) != numPolls1) result = EXIT_FAILURE;
+
+    //the next activation polls the devices again
+    device->activateStream(stream, 0, 0, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    if (numStatusReads(*device, 0) == numPolls0) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! Receive streams of the mock do not report status
+static int testNotSupported(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"channels=1", "channels=1"}));
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, SoapySDR::Kwargs());
+
+    size_t chanMask = 0;
+    int flags = 0;
+    long long timeNs = 0;
+    const int ret = device->readStreamStatus(stream, chanMask, flags, timeNs, 1000000);
+    device->closeStream(stream);
+    return (ret == SOAPY_SDR_NOT_SUPPORTED)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+int main(void)
+{
+    std::cout << "test readStreamStatus() burst acks from all devices..." << std::endl;
+    if (testBurstAcks() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStreamStatus() timeout on all devices..." << std::endl;
+    if (testTimeoutOnce() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStreamStatus() errors and deactivation..." << std::endl;
+    if (testStatusError() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test readStreamStatus() not supported..." << std::endl;
+    if (testNotSupported() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the merged writeStream() with mock devices which accept
+ * partial writes.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <iostream>
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+/*!
+ * Resubmitting the rest of a partial write sends every element to every device exactly once.
+ * The ramp is scaled down by the full-scale, which a native CS16 sub-stream scales up again.
+ */
+static int testPartialWrites(const SoapySDR::Kwargs &args, const float fullScale)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"short_reads=0.5", "", "channels=2,short_reads=0.8,mtu=300"}));
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, {0, 1, 2, 3}, args);
+    device->activateStream(stream, 0, 0, 0);
+
+    //the converted writes go through buffers which are not in the stream format
+    int result = EXIT_SUCCESS;
+    const bool native = args.count("multi:native") != 0 and args.at("multi:native") == "true";
+    if (native and device->getNumDirectAccessBuffers(stream) != 0) result = EXIT_FAILURE;
+
+    //the ramp which the mock devices check
+    std::vector<std::complex<float>> buff(20000);
+    for (size_t j = 0; j < buff.size(); j++) buff[j] = std::complex<float>(float(j & 0x7fff)/fullScale, 0.0f);
+
+    size_t numWritten = 0;
+    for (size_t i = 0; numWritten < buff.size() and result == EXIT_SUCCESS; i++)
+    {
+        //the caller resubmits from the first element which was not reported as written
+        const size_t numElems = std::min(buff.size() - numWritten, 100 + (i*53) % 900);
+        const void *buffs[4];
+        for (auto &ptr : buffs) ptr = buff.data() + numWritten;
+        int flags = 0;
+        const int ret = device->writeStream(stream, buffs, numElems, flags, 0, 100000);
+        if (ret < 0 or size_t(ret) > numElems or i > 10000) result = EXIT_FAILURE;
+        if (ret > 0) numWritten += size_t(ret);
+    }
+
+    //no element went missing or was sent twice on any device
+    for (const size_t i : {0, 1, 2})
+    {
+        const auto numElems = device->readSensor(toIndexedName("num_tx_elems", i));
+        const auto numRamp = device->readSensor(toIndexedName("num_tx_ramp", i));
+        if (numElems == std::to_string(buff.size()) and numRamp == numElems) continue;
+        std::cerr << "device " << i << " got " << numElems << " elements, " << numRamp << " in order" << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+int main(void)
+{
+    std::cout << "test writeStream() partial writes..." << std::endl;
+    if (testPartialWrites(SoapySDR::Kwargs(), 1.0f) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test writeStream() partial writes in parallel..." << std::endl;
+    SoapySDR::Kwargs parallel;
+    parallel["multi:parallel"] = "true";
+    if (testPartialWrites(parallel, 1.0f) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test writeStream() partial writes in the native format..." << std::endl;
+    SoapySDR::Kwargs native;
+    native["multi:native"] = "true";
+    if (testPartialWrites(native, 32768.0f) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2026 SoapyMultiSDR contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Test the aggregated acquireWriteBuffer() and acquireReadBuffer() with mock devices.
+ **********************************************************************/
+
+#include "TestMultiMock.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <iostream>
+#include <memory>
+#include <cstdlib>
+
+//! True when no device has direct access buffers which were not released
+static bool noneAcquired(SoapyMultiSDR &device)
+{
+    for (const auto &name : device.listSensors())
+    {
+        size_t index = 0;
+        if (splitIndexedName(name, index) != "num_acquired") continue;
+        if (device.readSensor(name) != "0") return false;
+    }
+    return true;
+}
+
+static int testWriteBuffer(const std::vector<std::string> &markups, const long timeoutUs, const int expected)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock(markups));
+    std::vector<size_t> channels(device->getNumChannels(SOAPY_SDR_TX));
+    for (size_t i = 0; i < channels.size(); i++) channels[i] = i;
+    auto stream = device->setupStream(SOAPY_SDR_TX, SOAPY_SDR_CF32, channels, SoapySDR::Kwargs());
+    device->activateStream(stream, 0, 0, 0);
+
+    //acquire more buffers than the devices have, each one is released again
+    int result = EXIT_SUCCESS;
+    for (size_t i = 0; i < 2*device->getNumDirectAccessBuffers(stream) and result == EXIT_SUCCESS; i++)
+    {
+        size_t handle = 0;
+        std::vector<void *> buffs(channels.size(), nullptr);
+        const int ret = device->acquireWriteBuffer(stream, handle, buffs.data(), timeoutUs);
+        if (ret != expected) result = EXIT_FAILURE;
+        if (ret <= 0) continue;
+
+        for (const auto buff : buffs) if (buff == nullptr) result = EXIT_FAILURE;
+        int flags = 0;
+        device->releaseWriteBuffer(stream, handle, size_t(ret), flags, 0);
+    }
+
+    //buffers acquired before a timeout were given back
+    if (not noneAcquired(*device)) result = EXIT_FAILURE;
+
+    device->deactivateStream(stream, 0, 0);
+    device->closeStream(stream);
+    return result;
+}
+
+//! A read acquire which times out on a later device resumes with the buffers it already has
+static int testReadBufferResume(void)
+{
+    std::unique_ptr<SoapyMultiSDR> device(makeMock({"", "latency_us=50000"}));
+    auto stream = device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, {0, 1}, SoapySDR::Kwargs());
+    device->activateStream(stream, 0, 0, 0);
+
+    int result = EXIT_SUCCESS;
+    size_t handle = 0;
+    const void *buffs[2] = {nullptr, nullptr};
+    int flags = 0;
+    long long timeNs = 0;
+    if (device->acquireReadBuffer(stream, handle, buffs, flags, timeNs, 10000) != SOAPY_SDR_TIMEOUT) result = EXIT_FAILURE;
+
+    //the buffer of the first device is kept rather than released with its samples
+    if (device->readSensor("num_acquired[0]") != "1") result = EXIT_FAILURE;
+    if (device->readSensor("num_acquired[1]") != "0") result = EXIT_FAILURE;
+
+    //both channels start on the first sample, the mock writes the sample count into the real part
+    const int ret = device->acquireReadBuffer(stream, handle, buffs, flags, timeNs, 1000000);
+    if (ret <= 0) result = EXIT_FAILURE;
+    else
+    {
+        const auto buff0 = static_cast<const float *>(buffs[0]);
+        const auto buff1 = static_cast<const float *>(buffs[1]);
+        if (buff0[0] != 0.0f or buff1[0] != 0.0f or buff0[2] != 1.0f) result = EXIT_FAILURE;
+        device->releaseReadBuffer(stream, handle);
+    }
+    if (not noneAcquired(*device)) result = EXIT_FAILURE;
+
+    //a partial acquire is given back when the stream stops
+    if (device->acquireReadBuffer(stream, handle, buffs, flags, timeNs, 10000) != SOAPY_SDR_TIMEOUT) result = EXIT_FAILURE;
+    device->deactivateStream(stream, 0, 0);
+    if (not noneAcquired(*device)) result = EXIT_FAILURE;
+
+    device->closeStream(stream);
+    return result;
+}
+
+int main(void)
+{
+    std::cout << "test acquireWriteBuffer() on all devices..." << std::endl;
+    if (testWriteBuffer({"num_buffs=2", "num_buffs=4", "num_buffs=3"}, 100000, 1024) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test acquireWriteBuffer() partial buffers..." << std::endl;
+    if (testWriteBuffer({"mtu=1024", "mtu=512", "mtu=2048"}, 100000, 512) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test acquireWriteBuffer() timeout on a later device..." << std::endl;
+    if (testWriteBuffer({"num_buffs=2", "latency_us=50000"}, 10000, SOAPY_SDR_TIMEOUT) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test acquireWriteBuffer() shared timeout..." << std::endl;
+    if (testWriteBuffer({"latency_us=20000", "latency_us=20000"}, 30000, SOAPY_SDR_TIMEOUT) != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (testWriteBuffer({"latency_us=20000", "latency_us=20000"}, 200000, 1024) != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    std::cout << "test acquireReadBuffer() resume after a timeout..." << std::endl;
+    if (testReadBufferResume() != EXIT_SUCCESS) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}